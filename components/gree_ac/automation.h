@@ -0,0 +1,68 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "gree_ac_cnt.h"
+
+namespace esphome {
+namespace gree_ac {
+
+/* gree_ac.apply_scene: set a whole parameter set at once, sent to the unit in a single update frame */
+template<typename... Ts> class ApplySceneAction : public Action<Ts...>, public Parented<CNT::GreeACCNT> {
+    public:
+        TEMPLATABLE_VALUE(climate::ClimateMode, mode)
+        TEMPLATABLE_VALUE(float, target_temperature)
+        TEMPLATABLE_VALUE(std::string, fan_mode)
+        TEMPLATABLE_VALUE(std::string, vertical_swing)
+        TEMPLATABLE_VALUE(std::string, horizontal_swing)
+        TEMPLATABLE_VALUE(std::string, quiet)
+        TEMPLATABLE_VALUE(bool, turbo)
+
+        void play(const Ts &...x) override {
+            CNT::SceneParams scene;
+            if (this->mode_.has_value())
+                scene.mode = this->mode_.value(x...);
+            if (this->target_temperature_.has_value())
+                scene.target_temperature = this->target_temperature_.value(x...);
+            if (this->fan_mode_.has_value())
+                scene.fan_mode = this->fan_mode_.value(x...);
+            if (this->vertical_swing_.has_value())
+                scene.vertical_swing = this->vertical_swing_.value(x...);
+            if (this->horizontal_swing_.has_value())
+                scene.horizontal_swing = this->horizontal_swing_.value(x...);
+            if (this->quiet_.has_value())
+                scene.quiet = this->quiet_.value(x...);
+            if (this->turbo_.has_value())
+                scene.turbo = this->turbo_.value(x...);
+            this->parent_->apply_scene(scene);
+        }
+};
+
+/* gree_ac.dump_flight_recorder: log the frames kept by the flight recorder */
+template<typename... Ts> class DumpFlightRecorderAction : public Action<Ts...>, public Parented<CNT::GreeACCNT> {
+    public:
+        void play(const Ts &...x) override { this->parent_->dump_flight_recorder(); }
+};
+
+/* gree_ac.dump_trace: log the trace ring, sniffer/trace2chrome.py converts the output */
+template<typename... Ts> class DumpTraceAction : public Action<Ts...>, public Parented<CNT::GreeACCNT> {
+    public:
+        void play(const Ts &...x) override { this->parent_->dump_trace(); }
+};
+
+/* gree_ac.dump_sync_stats: log the framing recovery distribution */
+template<typename... Ts> class DumpSyncStatsAction : public Action<Ts...>, public Parented<CNT::GreeACCNT> {
+    public:
+        void play(const Ts &...x) override { this->parent_->dump_sync_stats(); }
+};
+
+/* gree_ac.run_benchmarks: time the RX/TX hot paths and log the results as JSON lines */
+template<typename... Ts> class RunBenchmarksAction : public Action<Ts...>, public Parented<CNT::GreeACCNT> {
+    public:
+        TEMPLATABLE_VALUE(uint16_t, iterations)
+
+        void play(const Ts &...x) override { this->parent_->run_benchmarks(this->iterations_.value(x...)); }
+};
+
+}  // namespace gree_ac
+}  // namespace esphome
@@ -1,14 +1,24 @@
 #based on: https://github.com/DomiStyle/esphome-panasonic-ac
+from esphome import automation
 from esphome.const import (
     CONF_ID,
+    CONF_PLATFORM,
+    CONF_MODE,
+    CONF_FAN_MODE,
+    CONF_TARGET_TEMPERATURE,
     CONF_NAME,
     CONF_ICON,
     CONF_ENTITY_CATEGORY,
     ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_MILLISECOND,
 )
 import esphome.codegen as cg
 import esphome.config_validation as cv
+import esphome.final_validate as fv
 from esphome.components import uart, climate, sensor, select, switch, text_sensor
+from esphome.core import CORE
+from esphome.helpers import cpp_string_escape
 
 AUTO_LOAD = ["switch", "sensor", "select", "text_sensor"]
 DEPENDENCIES = ["uart"]
@@ -27,6 +37,12 @@ GreeACSelect = gree_ac_ns.class_(
     "GreeACSelect", select.Select, cg.Component
 )
 
+ApplySceneAction = gree_ac_ns.class_("ApplySceneAction", automation.Action)
+DumpFlightRecorderAction = gree_ac_ns.class_("DumpFlightRecorderAction", automation.Action)
+DumpTraceAction = gree_ac_ns.class_("DumpTraceAction", automation.Action)
+DumpSyncStatsAction = gree_ac_ns.class_("DumpSyncStatsAction", automation.Action)
+RunBenchmarksAction = gree_ac_ns.class_("RunBenchmarksAction", automation.Action)
+
 
 CONF_HORIZONTAL_SWING_SELECT    = "horizontal_swing_select"
 CONF_VERTICAL_SWING_SELECT      = "vertical_swing_select"
@@ -48,6 +64,90 @@ CONF_QUIET_SELECT               = "quiet_select"
 
 CONF_MODEL_ID_TEXT_SENSOR       = "model_id_text_sensor"
 
+CONF_VERTICAL_SWING             = "vertical_swing"
+CONF_HORIZONTAL_SWING           = "horizontal_swing"
+CONF_QUIET                      = "quiet"
+CONF_TURBO                      = "turbo"
+CONF_STATE_SNAPSHOT_TEXT_SENSOR = "state_snapshot_text_sensor"
+CONF_STATE_SNAPSHOT             = "state_snapshot"
+CONF_FLIGHT_RECORDER_SIZE       = "flight_recorder_size"
+CONF_ITERATIONS                 = "iterations"
+CONF_CLOCK_OFFSET               = "clock_offset"
+CONF_TRACE_BUFFER_SIZE          = "trace_buffer_size"
+CONF_PACKET_DUMP_FORMAT         = "packet_dump_format"
+
+CONF_LOOP_BUDGET                = "loop_budget"
+CONF_LOOP_TIMING_SENSORS        = "loop_timing_sensors"
+CONF_CONFIRM_LATENCY_SENSORS    = "confirm_latency_sensors"
+CONF_PUBLISH_BATCH_SIZE         = "publish_batch_size"
+CONF_PUBLISH_MIN_INTERVAL       = "publish_min_interval"
+CONF_PUBLISH_HEARTBEAT          = "publish_heartbeat"
+CONF_CURRENT_TEMPERATURE_DEADBAND = "current_temperature_deadband"
+CONF_EXCLUDE_ENTITIES           = "exclude_entities"
+CONF_FOOTPRINT_REPORT           = "footprint_report"
+CONF_RX_TASK                    = "rx_task"
+
+# entities which can be left out with exclude_entities; each one is compiled out with GREE_AC_NO_<KEY>
+OPTIONAL_ENTITIES = [
+    CONF_HORIZONTAL_SWING_SELECT,
+    CONF_VERTICAL_SWING_SELECT,
+    CONF_DISPLAY_SELECT,
+    CONF_DISPLAY_UNIT_SELECT,
+    CONF_LIGHT_SELECT,
+    CONF_QUIET_SELECT,
+    CONF_IONIZER_SWITCH,
+    CONF_BEEPER_SWITCH,
+    CONF_SLEEP_SWITCH,
+    CONF_XFAN_SWITCH,
+    CONF_POWERSAVE_SWITCH,
+    CONF_TURBO_SWITCH,
+    CONF_IFEEL_SWITCH,
+    CONF_ENABLE_TX_SWITCH,
+    CONF_DUMP_PACKETS_SWITCH,
+    CONF_MODEL_ID_TEXT_SENSOR,
+]
+
+
+def entity_define(conf_key):
+    return f"GREE_AC_NO_{conf_key.upper()}"
+
+# (key, display name, LoopPhase_t value) - timed sections of GreeACCNT::loop()
+LOOP_PHASES = [
+    ("ingest", "ingest", gree_ac_ns.LOOP_PHASE_INGEST),
+    ("verify", "verify", gree_ac_ns.LOOP_PHASE_VERIFY),
+    ("decode", "decode", gree_ac_ns.LOOP_PHASE_DECODE),
+    ("publish", "publish", gree_ac_ns.LOOP_PHASE_PUBLISH),
+    ("encode", "encode", gree_ac_ns.LOOP_PHASE_ENCODE),
+    ("tx", "TX", gree_ac_ns.LOOP_PHASE_TX),
+    ("total", "total", gree_ac_ns.LOOP_PHASE_TOTAL),
+]
+
+
+def loop_time_sensor_key(phase, kind):
+    return f"loop_{phase}_{kind}_sensor"
+
+
+# (kind, display name) of the command confirmation latency sensors, in set_confirm_latency_sensors() order
+CONFIRM_LATENCY_KINDS = [
+    ("p50", "median"),
+    ("p95", "p95"),
+    ("max", "max"),
+]
+
+
+def confirm_latency_sensor_key(kind):
+    return f"confirm_latency_{kind}_sensor"
+
+
+FAN_MODE_OPTIONS = [
+    "Auto",
+    "Minimum",
+    "Low",
+    "Medium",
+    "High",
+    "Maximum",
+]
+
 QUIET_OPTIONS = [
     "Off",
     "On",
@@ -96,6 +196,33 @@ DISPLAY_UNIT_OPTIONS = [
     "F",
 ]
 
+# C++ namespace in gree_ac_options.h holding the table for each list above
+OPTION_TABLES = [
+    ("fan_modes", FAN_MODE_OPTIONS),
+    ("quiet_options", QUIET_OPTIONS),
+    ("light_options", LIGHT_OPTIONS),
+    ("horizontal_swing_options", HORIZONTAL_SWING_OPTIONS),
+    ("vertical_swing_options", VERTICAL_SWING_OPTIONS),
+    ("display_options", DISPLAY_OPTIONS),
+    ("display_unit_options", DISPLAY_UNIT_OPTIONS),
+]
+
+
+def option_table_asserts():
+    """static_asserts which fail the build if an option list and its C++ table differ in size, order or spelling."""
+    lines = []
+    for namespace, options in OPTION_TABLES:
+        table = f"esphome::gree_ac::{namespace}"
+        message = cpp_string_escape(f"{namespace} in gree_ac_options.h does not match climate.py")
+        lines.append(f"static_assert({table}::COUNT == {len(options)}, {message});")
+        for index, option in enumerate(options):
+            lines.append(
+                f"static_assert(esphome::gree_ac::option_name_equal({table}::OPTIONS[{index}].name, "
+                f"{cpp_string_escape(option)}), {message});"
+            )
+    return "\n".join(lines)
+
+
 SCHEMA = climate.climate_schema(climate.Climate).extend(
     {
         cv.Optional(CONF_NAME, default="Thermostat"): cv.string_strict,
@@ -115,23 +242,93 @@ SCHEMA = climate.climate_schema(climate.Climate).extend(
         cv.GenerateID(CONF_DUMP_PACKETS_SWITCH): cv.declare_id(GreeACSwitch),
         cv.GenerateID(CONF_QUIET_SELECT): cv.declare_id(GreeACSelect),
         cv.GenerateID(CONF_MODEL_ID_TEXT_SENSOR): cv.declare_id(text_sensor.TextSensor),
+        cv.GenerateID(CONF_STATE_SNAPSHOT_TEXT_SENSOR): cv.declare_id(text_sensor.TextSensor),
+        cv.Optional(CONF_STATE_SNAPSHOT, default=False): cv.boolean,
+        cv.Optional(CONF_FLIGHT_RECORDER_SIZE, default=1024): cv.int_range(min=0, max=16384),
+        cv.Optional(CONF_TRACE_BUFFER_SIZE, default=128): cv.int_range(min=0, max=2048),
+        cv.Optional(CONF_PACKET_DUMP_FORMAT, default="text"): cv.one_of("text", "capture", lower=True),
+        cv.Optional(CONF_CLOCK_OFFSET, default="0ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=0xFFFFFFFF)),
+        ),
+        cv.Optional(CONF_LOOP_BUDGET, default="10ms"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_LOOP_TIMING_SENSORS, default=False): cv.boolean,
+        cv.Optional(CONF_CONFIRM_LATENCY_SENSORS, default=False): cv.boolean,
+        cv.Optional(CONF_PUBLISH_BATCH_SIZE, default=3): cv.int_range(min=1, max=14),
+        cv.Optional(CONF_PUBLISH_MIN_INTERVAL, default="0ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PUBLISH_HEARTBEAT, default="0ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_CURRENT_TEMPERATURE_DEADBAND, default=0.0): cv.float_range(min=0.0, max=10.0),
+        cv.Optional(CONF_EXCLUDE_ENTITIES, default=[]): cv.ensure_list(cv.one_of(*OPTIONAL_ENTITIES, lower=True)),
+        cv.Optional(CONF_FOOTPRINT_REPORT, default=False): cv.boolean,
+        cv.Optional(CONF_RX_TASK, default=False): cv.boolean,
+        **{
+            cv.GenerateID(loop_time_sensor_key(phase, kind)): cv.declare_id(sensor.Sensor)
+            for phase, _, _ in LOOP_PHASES
+            for kind in ("max", "avg")
+        },
+        **{
+            cv.GenerateID(confirm_latency_sensor_key(kind)): cv.declare_id(sensor.Sensor)
+            for kind, _ in CONFIRM_LATENCY_KINDS
+        },
     }
 ).extend(uart.UART_DEVICE_SCHEMA)
 
+
+
+def validate_rx_task(config):
+    # the RX task is a FreeRTOS task, the ESP8266 has none
+    if config[CONF_RX_TASK] and not CORE.is_esp32:
+        raise cv.Invalid(f"{CONF_RX_TASK} is only available on ESP32")
+    return config
+
+
 CONFIG_SCHEMA = cv.All(
     SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(GreeACCNT),
         }
     ),
+    validate_rx_task,
 )
 
+# options which become GREE_AC_* defines; those apply to the whole build, so every gree_ac climate has to agree
+BUILD_WIDE_OPTIONS = [CONF_EXCLUDE_ENTITIES, CONF_FOOTPRINT_REPORT, CONF_RX_TASK]
+
+
+def build_wide_value(config, key):
+    value = config[key]
+    return sorted(set(value)) if key == CONF_EXCLUDE_ENTITIES else value
+
+
+def final_validate_build_wide_options(config):
+    climates = fv.full_config.get().get("climate", [])
+    first = next(conf for conf in climates if conf.get(CONF_PLATFORM) == "gree_ac")
+    for key in BUILD_WIDE_OPTIONS:
+        if build_wide_value(config, key) != build_wide_value(first, key):
+            raise cv.Invalid(
+                f"{key} is compiled into every gree_ac climate, it has to be the same on all of them",
+                path=[key],
+            )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_build_wide_options
+
 
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await climate.register_climate(var, config)
     await cg.register_component(var, config)
     await uart.register_uart_device(var, config)
+    cg.add_global(cg.RawStatement(option_table_asserts()))
+
+    excluded = set(config[CONF_EXCLUDE_ENTITIES])
+    for conf_key in sorted(excluded):
+        cg.add_define(entity_define(conf_key))
+    if config[CONF_FOOTPRINT_REPORT]:
+        cg.add_define("GREE_AC_FOOTPRINT_REPORT")
+    if config[CONF_RX_TASK]:
+        cg.add_define("GREE_AC_RX_TASK")
 
     selects = [
         (
@@ -178,6 +375,8 @@ async def to_code(config):
         ),
     ]
     for conf_key, name, options, setter, icon in selects:
+        if conf_key in excluded:
+            continue
         sel_id = config[conf_key]
         sel_conf = select.select_schema(GreeACSelect)(
             {CONF_ID: sel_id, CONF_NAME: name, CONF_ICON: icon}
@@ -198,6 +397,8 @@ async def to_code(config):
         (CONF_DUMP_PACKETS_SWITCH, "Dump packets", "set_dump_packets_switch", "mdi:details"),
     ]
     for conf_key, name, setter, icon in switches:
+        if conf_key in excluded:
+            continue
         sw_id = config[conf_key]
         sw_conf = {
             CONF_ID: sw_id,
@@ -212,10 +413,143 @@ async def to_code(config):
         await cg.register_component(sw_var, sw_conf)
         cg.add(getattr(var, setter)(sw_var))
 
-    ts_id = config[CONF_MODEL_ID_TEXT_SENSOR]
-    ts_conf = text_sensor.text_sensor_schema(
-        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
-        icon="mdi:information-outline",
-    )({CONF_ID: ts_id, CONF_NAME: "Model ID"})
-    ts_var = await text_sensor.new_text_sensor(ts_conf)
-    cg.add(var.set_model_id_text_sensor(ts_var))
+    if CONF_MODEL_ID_TEXT_SENSOR not in excluded:
+        ts_id = config[CONF_MODEL_ID_TEXT_SENSOR]
+        ts_conf = text_sensor.text_sensor_schema(
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            icon="mdi:information-outline",
+        )({CONF_ID: ts_id, CONF_NAME: "Model ID"})
+        ts_var = await text_sensor.new_text_sensor(ts_conf)
+        cg.add(var.set_model_id_text_sensor(ts_var))
+
+    if config[CONF_STATE_SNAPSHOT]:
+        snap_conf = text_sensor.text_sensor_schema(
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            icon="mdi:code-json",
+        )({CONF_ID: config[CONF_STATE_SNAPSHOT_TEXT_SENSOR], CONF_NAME: "State snapshot"})
+        snap_var = await text_sensor.new_text_sensor(snap_conf)
+        cg.add(var.set_state_snapshot_text_sensor(snap_var))
+
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET].total_microseconds))
+    cg.add(var.set_publish_batch_size(config[CONF_PUBLISH_BATCH_SIZE]))
+    cg.add(var.set_publish_min_interval(config[CONF_PUBLISH_MIN_INTERVAL].total_milliseconds))
+    cg.add(var.set_publish_heartbeat(config[CONF_PUBLISH_HEARTBEAT].total_milliseconds))
+    cg.add(var.set_current_temperature_deadband(config[CONF_CURRENT_TEMPERATURE_DEADBAND]))
+    cg.add(var.set_flight_recorder_size(config[CONF_FLIGHT_RECORDER_SIZE]))
+    cg.add(var.set_trace_buffer_size(config[CONF_TRACE_BUFFER_SIZE]))
+    cg.add(var.set_packet_dump_capture(config[CONF_PACKET_DUMP_FORMAT] == "capture"))
+    if config[CONF_CLOCK_OFFSET].total_milliseconds > 0:
+        cg.add(var.set_clock_offset(config[CONF_CLOCK_OFFSET].total_milliseconds))
+
+    if config[CONF_LOOP_TIMING_SENSORS]:
+        for phase, name, phase_enum in LOOP_PHASES:
+            phase_sensors = []
+            for kind in ("max", "avg"):
+                s_conf = sensor.sensor_schema(
+                    unit_of_measurement=UNIT_MILLISECOND,
+                    accuracy_decimals=3,
+                    state_class=STATE_CLASS_MEASUREMENT,
+                    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                    icon="mdi:timer-outline",
+                )({CONF_ID: config[loop_time_sensor_key(phase, kind)], CONF_NAME: f"Loop {name} {kind}"})
+                phase_sensors.append(await sensor.new_sensor(s_conf))
+            cg.add(var.set_loop_time_sensors(phase_enum, *phase_sensors))
+
+    if config[CONF_CONFIRM_LATENCY_SENSORS]:
+        latency_sensors = []
+        for kind, name in CONFIRM_LATENCY_KINDS:
+            s_conf = sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:timer-check-outline",
+            )({CONF_ID: config[confirm_latency_sensor_key(kind)], CONF_NAME: f"Command latency {name}"})
+            latency_sensors.append(await sensor.new_sensor(s_conf))
+        cg.add(var.set_confirm_latency_sensors(*latency_sensors))
+
+
+APPLY_SCENE_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(GreeACCNT),
+        cv.Optional(CONF_MODE): cv.templatable(climate.validate_climate_mode),
+        cv.Optional(CONF_TARGET_TEMPERATURE): cv.templatable(cv.temperature),
+        cv.Optional(CONF_FAN_MODE): cv.templatable(cv.one_of(*FAN_MODE_OPTIONS)),
+        cv.Optional(CONF_VERTICAL_SWING): cv.templatable(cv.one_of(*VERTICAL_SWING_OPTIONS)),
+        cv.Optional(CONF_HORIZONTAL_SWING): cv.templatable(cv.one_of(*HORIZONTAL_SWING_OPTIONS)),
+        cv.Optional(CONF_QUIET): cv.templatable(cv.one_of(*QUIET_OPTIONS)),
+        cv.Optional(CONF_TURBO): cv.templatable(cv.boolean),
+    }
+)
+
+
+@automation.register_action("gree_ac.apply_scene", ApplySceneAction, APPLY_SCENE_SCHEMA)
+async def apply_scene_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+
+    fields = [
+        (CONF_MODE, climate.ClimateMode, "set_mode"),
+        (CONF_TARGET_TEMPERATURE, cg.float_, "set_target_temperature"),
+        (CONF_FAN_MODE, cg.std_string, "set_fan_mode"),
+        (CONF_VERTICAL_SWING, cg.std_string, "set_vertical_swing"),
+        (CONF_HORIZONTAL_SWING, cg.std_string, "set_horizontal_swing"),
+        (CONF_QUIET, cg.std_string, "set_quiet"),
+        (CONF_TURBO, cg.bool_, "set_turbo"),
+    ]
+    for conf_key, type_, setter in fields:
+        if conf_key in config:
+            template_ = await cg.templatable(config[conf_key], args, type_)
+            cg.add(getattr(var, setter)(template_))
+    return var
+
+
+@automation.register_action(
+    "gree_ac.dump_flight_recorder",
+    DumpFlightRecorderAction,
+    automation.maybe_simple_id({cv.GenerateID(): cv.use_id(GreeACCNT)}),
+)
+async def dump_flight_recorder_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action(
+    "gree_ac.dump_trace",
+    DumpTraceAction,
+    automation.maybe_simple_id({cv.GenerateID(): cv.use_id(GreeACCNT)}),
+)
+async def dump_trace_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action(
+    "gree_ac.dump_sync_stats",
+    DumpSyncStatsAction,
+    automation.maybe_simple_id({cv.GenerateID(): cv.use_id(GreeACCNT)}),
+)
+async def dump_sync_stats_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+@automation.register_action(
+    "gree_ac.run_benchmarks",
+    RunBenchmarksAction,
+    automation.maybe_simple_id(
+        {
+            cv.GenerateID(): cv.use_id(GreeACCNT),
+            cv.Optional(CONF_ITERATIONS, default=200): cv.templatable(cv.int_range(min=1, max=5000)),
+        }
+    ),
+)
+async def run_benchmarks_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_ITERATIONS], args, cg.uint16)
+    cg.add(var.set_iterations(template_))
+    return var
@@ -1,8 +1,13 @@
 // based on: https://github.com/DomiStyle/esphome-panasonic-ac
 #include "gree_ac.h"
 
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
+#include <cmath>
+#include <cstdarg>
+#include <cstring>
+
 namespace esphome {
 namespace gree_ac {
 
@@ -15,62 +20,129 @@ const uint8_t GreeAC::MAX_TEMPERATURE = 30;
 const float GreeAC::TEMPERATURE_STEP = 1.0;
 const float GreeAC::TEMPERATURE_TOLERANCE = 2;
 const uint8_t GreeAC::TEMPERATURE_THRESHOLD = 100;
-const uint8_t GreeAC::DATA_MAX = 200;
+const uint32_t GreeAC::LOOP_STATS_PERIOD_MS = 60000;
+const uint8_t GreeAC::SNAPSHOT_VERSION = 1;
+
+static const uint8_t PACKET_LOG_CHUNK = 64;  // bytes per log line of a packet dump
+
+/* GCAP record header, see documents/capture-format.txt */
+static const uint8_t CAPTURE_HEADER_LEN = 6;
+static const uint8_t CAPTURE_DIR_FROM_UNIT = 0;
+static const uint8_t CAPTURE_DIR_TO_UNIT = 1;
+
+#ifdef GREE_AC_RX_TASK
+static const uint32_t RX_TASK_STACK_SIZE = 3072;
+static const UBaseType_t RX_TASK_PRIORITY = 5;  // above the loop task, below WiFi
+static const uint32_t RX_TASK_POLL_MS = 2;      // a byte takes ~2 ms at 4800 baud, the UART driver buffers the rest
+#endif
 
+static const char LOOP_PHASE_NAMES[LOOP_PHASE_COUNT][8] PROGMEM = {
+    "ingest", "verify", "decode", "publish", "encode", "tx", "total"
+};
+
+/* the traits never change, so they are built on the first call only. Climate::traits() returns them by value,
+   so every call still copies the cached object, custom fan mode vector (one heap allocation) included */
 climate::ClimateTraits GreeAC::traits()
 {
-    auto traits = climate::ClimateTraits();
+    if (this->traits_built_)
+        return this->traits_;
 
-    traits.add_feature_flags(climate::CLIMATE_SUPPORTS_CURRENT_TEMPERATURE);
-    traits.set_visual_min_temperature(MIN_TEMPERATURE);
-    traits.set_visual_max_temperature(MAX_TEMPERATURE);
-    traits.set_visual_temperature_step(TEMPERATURE_STEP);
+    this->traits_.add_feature_flags(climate::CLIMATE_SUPPORTS_CURRENT_TEMPERATURE);
+    this->traits_.set_visual_min_temperature(MIN_TEMPERATURE);
+    this->traits_.set_visual_max_temperature(MAX_TEMPERATURE);
+    this->traits_.set_visual_temperature_step(TEMPERATURE_STEP);
 
-    traits.set_supported_modes({climate::CLIMATE_MODE_OFF, climate::CLIMATE_MODE_AUTO, climate::CLIMATE_MODE_COOL,
-                                climate::CLIMATE_MODE_HEAT, climate::CLIMATE_MODE_FAN_ONLY, climate::CLIMATE_MODE_DRY});
+    this->traits_.set_supported_modes({climate::CLIMATE_MODE_OFF, climate::CLIMATE_MODE_AUTO, climate::CLIMATE_MODE_COOL,
+                                       climate::CLIMATE_MODE_HEAT, climate::CLIMATE_MODE_FAN_ONLY, climate::CLIMATE_MODE_DRY});
 
-    traits.set_supported_fan_modes({climate::CLIMATE_FAN_AUTO, climate::CLIMATE_FAN_LOW,
-                                    climate::CLIMATE_FAN_MEDIUM, climate::CLIMATE_FAN_HIGH});
+    this->traits_.set_supported_fan_modes({climate::CLIMATE_FAN_AUTO, climate::CLIMATE_FAN_LOW,
+                                           climate::CLIMATE_FAN_MEDIUM, climate::CLIMATE_FAN_HIGH});
 
-    traits.set_supported_custom_fan_modes({fan_modes::FAN_MIN, fan_modes::FAN_MAX});
+    /* static strings, the vector holds pointers only */
+    this->traits_.set_supported_custom_fan_modes({fan_modes::MIN_NAME, fan_modes::MAX_NAME});
 
-    return traits;
+    this->traits_built_ = true;
+    return this->traits_;
 }
 
 void GreeAC::setup()
 {
   // Initialize times
-    this->init_time_ = millis();
-    this->last_packet_sent_ = millis();
+    uint32_t now = this->now_();
+    this->init_time_ = now;
+    this->last_packet_sent_ = now;
+    this->last_packet_received_ = now;
     this->light_mode_ = light_options::AUTO;
     this->light_state_ = false;
 
+#ifndef GREE_AC_NO_LIGHT_SELECT
     if (this->light_select_ != nullptr) {
-        this->light_select_->publish_state(this->light_mode_);
+        this->light_select_->publish_state((size_t) this->light_mode_);
     }
+#endif
 
+#ifndef GREE_AC_NO_ENABLE_TX_SWITCH
     if (this->enable_tx_switch_ != nullptr) {
         this->enable_tx_switch_->publish_state(true);
     }
+#endif
 
+#ifndef GREE_AC_NO_DUMP_PACKETS_SWITCH
     if (this->dump_packets_switch_ != nullptr) {
         this->dump_packets_switch_->publish_state(false);
     }
+#endif
 
-    this->serialProcess_.state = STATE_WAIT_SYNC;
-    this->serialProcess_.last_byte_time = millis();
-    this->serialProcess_.size = 0;
+    serial_process_reset(&this->serialProcess_);
+    this->serialProcess_.last_byte_time = now;
+
+    this->recorder_.init(this->flight_recorder_size_);
+    this->tracer_.init(this->trace_buffer_size_);
+
+    this->loop_budget_cycles_ = this->loop_budget_us_ * (arch_get_cpu_freq_hz() / 1000000);
+    this->last_loop_stats_published_ = now;
+    for (uint32_t &published : this->last_published_) {
+        published = now;
+    }
 
     ESP_LOGI(TAG, "Gree AC component v%s starting...", VERSION);
+
+#ifdef GREE_AC_RX_TASK
+    this->rx_queue_ = new FrameQueue();
+    if (xTaskCreate(&GreeAC::rx_task_, "gree_ac_rx", RX_TASK_STACK_SIZE, this, RX_TASK_PRIORITY,
+                    &this->rx_task_handle_) != pdPASS) {
+        ESP_LOGE(TAG, "Could not start the RX task");
+        this->mark_failed();
+    }
+#endif
 }
 
 void GreeAC::dump_config() {
     LOG_CLIMATE("", "Gree AC", this);
     ESP_LOGCONFIG(TAG, "  Component Version: %s", VERSION);
+    if (this->loop_budget_us_ > 0) {
+        ESP_LOGCONFIG(TAG, "  Loop budget: %u us", (unsigned) this->loop_budget_us_);
+    } else {
+        ESP_LOGCONFIG(TAG, "  Loop budget: unlimited");
+    }
+    ESP_LOGCONFIG(TAG, "  Packet dump format: %s", this->packet_dump_capture_ ? "capture" : "text");
+    if (this->clock_offset_ != 0) {
+        ESP_LOGCONFIG(TAG, "  Clock offset: %u ms", (unsigned) this->clock_offset_);
+    }
+#ifdef GREE_AC_RX_TASK
+    ESP_LOGCONFIG(TAG, "  RX task: %u frame slots", (unsigned) FrameQueue::SLOTS);
+#endif
 }
 
 void GreeAC::loop()
 {
+  this->loop_start_cycles_ = arch_get_cpu_cycle_count();
+
+#ifdef GREE_AC_RX_TASK
+  if (this->take_queued_frame_()) {
+    this->loop_phase_record_(LOOP_PHASE_INGEST, this->loop_start_cycles_);
+  }
+#else
   uint8_t loop_count = 0;
   while (available() && loop_count < 32) {
     if (this->serialProcess_.state == STATE_COMPLETE) {
@@ -82,41 +154,112 @@ void GreeAC::loop()
     if (!this->read_byte(&c)) {
       break;
     }
-    uint32_t now = millis();
+    uint32_t now = this->now_();
     this->serialProcess_.last_byte_time = now;
+    if (serial_process_feed(&this->serialProcess_, c)) {
+      this->trace_(TRACE_RX_FRAME, this->serialProcess_.size);
+    } else if (this->serialProcess_.size == 1) {
+      this->trace_(TRACE_RX_FIRST_BYTE);
+    }
+
+    if (this->serialProcess_.discarded > 0) {
+      this->note_sync_loss_(this->serialProcess_.discarded, now);
+      this->serialProcess_.discarded = 0;
+    }
+  }
+
+  if (loop_count > 0) {
+    this->loop_phase_record_(LOOP_PHASE_INGEST, this->loop_start_cycles_);
+  }
 
-    this->serialProcess_.data[this->serialProcess_.size++] = c;
-    size_t s = this->serialProcess_.size;
+  /* a frame which stopped halfway is dropped, otherwise it would keep the loop at high frequency */
+  uint32_t now = this->now_();
+  if (this->serialProcess_.size > 0 && this->serialProcess_.state != STATE_COMPLETE &&
+      now - this->serialProcess_.last_byte_time > READ_TIMEOUT) {
+    this->note_sync_loss_(this->serialProcess_.size, now);
+    serial_process_reset(&this->serialProcess_);
+  }
+#endif
+}
 
-    // Check for sync marker within packet (resync)
-    if (s >= 2 && this->serialProcess_.data[s-2] == 0x7E && this->serialProcess_.data[s-1] == 0x7E) {
-        if (s > 2) {
-            this->serialProcess_.data[0] = 0x7E;
-            this->serialProcess_.data[1] = 0x7E;
-            this->serialProcess_.size = 2;
-            s = 2;
+#ifdef GREE_AC_RX_TASK
+/*
+ * Receive side of rx_task: framing and the checksum run here, next to the UART, so a long loop() of another
+ * component cannot overflow the UART buffer. Never returns, the component lives as long as the firmware.
+ *
+ * The task reads the UART while transmit_packet() writes to it from the main loop. This relies on the UART
+ * component being safe for one reader and one writer at a time: ESPHome's ESP-IDF UART takes its own lock
+ * around every call and the IDF driver keeps separate RX and TX buffers, HardwareSerial on Arduino does the
+ * same with its HAL lock. available() and read_byte() share the peek byte of the UART component, so the task
+ * has to stay the only reader; loop() does not touch the receive side in this mode.
+ */
+void GreeAC::rx_task_(void *arg)
+{
+    GreeAC *self = static_cast<GreeAC *>(arg);
+    SerialProcess_t sp;
+    serial_process_reset(&sp);
+    uint32_t discarded = 0;
+    uint32_t first_us = 0;
+    uint32_t last_byte_time = 0;
+
+    for (;;) {
+        /* a frame which stopped halfway is counted with the discarded bytes of the next one */
+        if (sp.size > 0 && self->now_() - last_byte_time > READ_TIMEOUT) {
+            discarded += sp.size;
+            serial_process_reset(&sp);
         }
-    } else if (s == 1 && this->serialProcess_.data[0] != 0x7E) {
-        this->serialProcess_.size = 0;
-        continue;
-    } else if (s == 2 && this->serialProcess_.data[0] == 0x7E && this->serialProcess_.data[1] != 0x7E) {
-        this->serialProcess_.size = 0;
-        continue;
-    }
 
-    if (s == 3) {
-      this->serialProcess_.frame_size = c;
+        uint8_t c;
+        while (self->available() && self->read_byte(&c)) {
+            last_byte_time = self->now_();
+            bool complete = serial_process_feed(&sp, c);
+            discarded += sp.discarded;
+            sp.discarded = 0;
+            if (!complete) {
+                if (sp.size == 1)
+                    first_us = micros();
+                continue;
+            }
+
+            bool checksum_ok = sp.size >= 5 && frame_checksum(sp.data, sp.size) == sp.data[sp.size - 1];
+            self->rx_queue_->push(sp.data, sp.size, checksum_ok, discarded, self->now_(), micros(), first_us);
+            discarded = 0;
+            serial_process_reset(&sp);
+        }
+        vTaskDelay(pdMS_TO_TICKS(RX_TASK_POLL_MS));
     }
+}
 
-    if (s >= 3 && s == (size_t)(this->serialProcess_.frame_size + 3)) {
-      this->serialProcess_.state = STATE_COMPLETE;
+/* moves the oldest frame of the RX task into serialProcess_, GreeACCNT::loop() handles it from there as before */
+bool GreeAC::take_queued_frame_()
+{
+    uint32_t dropped = this->rx_queue_->dropped();
+    if (dropped != this->rx_dropped_logged_) {
+        ESP_LOGW(TAG, "RX queue full, %u frames dropped", (unsigned) (dropped - this->rx_dropped_logged_));
+        this->rx_dropped_logged_ = dropped;
     }
 
-    if (s >= DATA_MAX) {
-      this->serialProcess_.size = 0;
+    if (this->serialProcess_.state == STATE_COMPLETE)
+        return false;
+    const QueuedFrame_t *frame = this->rx_queue_->front();
+    if (frame == nullptr)
+        return false;
+
+    if (frame->discarded > 0) {
+        this->note_sync_loss_(frame->discarded, frame->time_ms);
     }
-  }
+    memcpy(this->serialProcess_.data, frame->data, frame->size);
+    this->serialProcess_.size = frame->size;
+    this->serialProcess_.state = STATE_COMPLETE;
+    this->serialProcess_.last_byte_time = frame->time_ms;
+    this->rx_checksum_ok_ = frame->checksum_ok;
+    /* both recorded now with the task's timestamps, so the ring may hold them after later events */
+    this->tracer_.record(TRACE_RX_FIRST_BYTE, 0, frame->first_us);
+    this->tracer_.record(TRACE_RX_FRAME, frame->size, frame->time_us);
+    this->rx_queue_->pop();
+    return true;
 }
+#endif
 
 bool GreeAC::update_current_temperature(float temperature)
 {
@@ -125,7 +268,8 @@ bool GreeAC::update_current_temperature(float temperature)
         return false;
     }
 
-    if (this->current_temperature == temperature)
+    /* deadband: a sensor dithering around the last published value does not count as a change */
+    if (std::fabs(this->current_temperature - temperature) <= this->current_temperature_deadband_)
         return false;
 
     this->current_temperature = temperature;
@@ -146,28 +290,34 @@ bool GreeAC::update_target_temperature(float temperature)
     return true;
 }
 
-bool GreeAC::update_fan_mode(const std::string &fan_mode)
+bool GreeAC::update_fan_mode(uint8_t fan_mode)
 {
     if (fan_mode == fan_modes::FAN_MIN || fan_mode == fan_modes::FAN_MAX) {
-        if (this->get_custom_fan_mode() == fan_mode)
+        const char *name = fan_mode == fan_modes::FAN_MIN ? fan_modes::MIN_NAME : fan_modes::MAX_NAME;
+        if (this->get_custom_fan_mode() == name)
             return false;
         this->fan_mode.reset();
-        this->set_custom_fan_mode_(fan_mode.c_str());
+        this->set_custom_fan_mode_(name);
         return true;
     }
 
     climate::ClimateFanMode new_fan_mode;
-    if (fan_mode == fan_modes::FAN_AUTO) {
-        new_fan_mode = climate::CLIMATE_FAN_AUTO;
-    } else if (fan_mode == fan_modes::FAN_LOW) {
-        new_fan_mode = climate::CLIMATE_FAN_LOW;
-    } else if (fan_mode == fan_modes::FAN_MED) {
-        new_fan_mode = climate::CLIMATE_FAN_MEDIUM;
-    } else if (fan_mode == fan_modes::FAN_HIGH) {
-        new_fan_mode = climate::CLIMATE_FAN_HIGH;
-    } else {
-        ESP_LOGW(TAG, "Unknown fan mode: %s", fan_mode.c_str());
-        return false;
+    switch (fan_mode) {
+        case fan_modes::FAN_AUTO:
+            new_fan_mode = climate::CLIMATE_FAN_AUTO;
+            break;
+        case fan_modes::FAN_LOW:
+            new_fan_mode = climate::CLIMATE_FAN_LOW;
+            break;
+        case fan_modes::FAN_MED:
+            new_fan_mode = climate::CLIMATE_FAN_MEDIUM;
+            break;
+        case fan_modes::FAN_HIGH:
+            new_fan_mode = climate::CLIMATE_FAN_HIGH;
+            break;
+        default:
+            ESP_LOGW(TAG, "Unknown fan mode: %u", fan_mode);
+            return false;
     }
 
     if (this->fan_mode == new_fan_mode && this->get_custom_fan_mode().empty())
@@ -178,63 +328,43 @@ bool GreeAC::update_fan_mode(const std::string &fan_mode)
     return true;
 }
 
-bool GreeAC::update_swing_horizontal(const std::string &swing)
+bool GreeAC::update_swing_horizontal(uint8_t swing)
 {
     if (this->horizontal_swing_state_ == swing)
         return false;
 
     this->horizontal_swing_state_ = swing;
-
-    if (this->horizontal_swing_select_ != nullptr &&
-        this->horizontal_swing_select_->current_option() != this->horizontal_swing_state_)
-    {
-        this->horizontal_swing_select_->publish_state(this->horizontal_swing_state_);
-    }
+    this->mark_for_publish_(PUBLISH_HORIZONTAL_SWING);
     return true;
 }
 
-bool GreeAC::update_swing_vertical(const std::string &swing)
+bool GreeAC::update_swing_vertical(uint8_t swing)
 {
     if (this->vertical_swing_state_ == swing)
         return false;
 
     this->vertical_swing_state_ = swing;
-
-    if (this->vertical_swing_select_ != nullptr && 
-        this->vertical_swing_select_->current_option() != this->vertical_swing_state_)
-    {
-        this->vertical_swing_select_->publish_state(this->vertical_swing_state_);
-    }
+    this->mark_for_publish_(PUBLISH_VERTICAL_SWING);
     return true;
 }
 
-bool GreeAC::update_display(const std::string &display)
+bool GreeAC::update_display(uint8_t display)
 {
     if (this->display_state_ == display)
         return false;
 
     this->display_state_ = display;
-
-    if (this->display_select_ != nullptr && 
-        this->display_select_->current_option() != this->display_state_)
-    {
-        this->display_select_->publish_state(this->display_state_);
-    }
+    this->mark_for_publish_(PUBLISH_DISPLAY);
     return true;
 }
 
-bool GreeAC::update_display_unit(const std::string &display_unit)
+bool GreeAC::update_display_unit(uint8_t display_unit)
 {
     if (this->display_unit_state_ == display_unit)
         return false;
 
     this->display_unit_state_ = display_unit;
-
-    if (this->display_unit_select_ != nullptr && 
-        this->display_unit_select_->current_option() != this->display_unit_state_)
-    {
-        this->display_unit_select_->publish_state(this->display_unit_state_);
-    }
+    this->mark_for_publish_(PUBLISH_DISPLAY_UNIT);
     return true;
 }
 
@@ -243,12 +373,13 @@ bool GreeAC::update_light(bool light)
     bool changed = (this->light_state_ != light);
     this->light_state_ = light;
 
-    if (this->light_select_ != nullptr &&
-        this->light_select_->current_option() != this->light_mode_)
+#ifndef GREE_AC_NO_LIGHT_SELECT
+    if (this->light_select_ != nullptr && !this->select_shows_(this->light_select_, this->light_mode_))
     {
-        this->light_select_->publish_state(this->light_mode_);
+        this->mark_for_publish_(PUBLISH_LIGHT);
         changed = true;
     }
+#endif
     return changed;
 }
 
@@ -258,11 +389,7 @@ bool GreeAC::update_ionizer(bool ionizer)
         return false;
 
     this->ionizer_state_ = ionizer;
-
-    if (this->ionizer_switch_ != nullptr)
-    {
-        this->ionizer_switch_->publish_state(this->ionizer_state_);
-    }
+    this->mark_for_publish_(PUBLISH_IONIZER);
     return true;
 }
 
@@ -272,11 +399,7 @@ bool GreeAC::update_beeper(bool beeper)
         return false;
 
     this->beeper_state_ = beeper;
-
-    if (this->beeper_switch_ != nullptr)
-    {
-        this->beeper_switch_->publish_state(this->beeper_state_);
-    }
+    this->mark_for_publish_(PUBLISH_BEEPER);
     return true;
 }
 
@@ -286,11 +409,7 @@ bool GreeAC::update_sleep(bool sleep)
         return false;
 
     this->sleep_state_ = sleep;
-
-    if (this->sleep_switch_ != nullptr)
-    {
-        this->sleep_switch_->publish_state(this->sleep_state_);
-    }
+    this->mark_for_publish_(PUBLISH_SLEEP);
     return true;
 }
 
@@ -300,11 +419,7 @@ bool GreeAC::update_xfan(bool xfan)
         return false;
 
     this->xfan_state_ = xfan;
-
-    if (this->xfan_switch_ != nullptr)
-    {
-        this->xfan_switch_->publish_state(this->xfan_state_);
-    }
+    this->mark_for_publish_(PUBLISH_XFAN);
     return true;
 }
 
@@ -314,11 +429,7 @@ bool GreeAC::update_powersave(bool powersave)
         return false;
 
     this->powersave_state_ = powersave;
-
-    if (this->powersave_switch_ != nullptr)
-    {
-        this->powersave_switch_->publish_state(this->powersave_state_);
-    }
+    this->mark_for_publish_(PUBLISH_POWERSAVE);
     return true;
 }
 
@@ -328,11 +439,7 @@ bool GreeAC::update_turbo(bool turbo)
         return false;
 
     this->turbo_state_ = turbo;
-
-    if (this->turbo_switch_ != nullptr)
-    {
-        this->turbo_switch_->publish_state(this->turbo_state_);
-    }
+    this->mark_for_publish_(PUBLISH_TURBO);
     return true;
 }
 
@@ -342,26 +449,17 @@ bool GreeAC::update_ifeel(bool ifeel)
         return false;
 
     this->ifeel_state_ = ifeel;
-
-    if (this->ifeel_switch_ != nullptr)
-    {
-        this->ifeel_switch_->publish_state(this->ifeel_state_);
-    }
+    this->mark_for_publish_(PUBLISH_IFEEL);
     return true;
 }
 
-bool GreeAC::update_quiet(const std::string &quiet)
+bool GreeAC::update_quiet(uint8_t quiet)
 {
     if (this->quiet_state_ == quiet)
         return false;
 
     this->quiet_state_ = quiet;
-
-    if (this->quiet_select_ != nullptr &&
-        this->quiet_select_->current_option() != this->quiet_state_)
-    {
-        this->quiet_select_->publish_state(this->quiet_state_);
-    }
+    this->mark_for_publish_(PUBLISH_QUIET);
     return true;
 }
 
@@ -388,61 +486,67 @@ climate::ClimateAction GreeAC::determine_action()
  * Sensor handling
  */
 
+#ifndef GREE_AC_NO_VERTICAL_SWING_SELECT
 void GreeAC::set_vertical_swing_select(select::Select *vertical_swing_select)
 {
     this->vertical_swing_select_ = vertical_swing_select;
     this->vertical_swing_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->vertical_swing_select_->at(index);
-        if (!value.has_value() || *value == this->vertical_swing_state_)
+        if (index >= vertical_swing_options::COUNT || index == this->vertical_swing_state_)
             return;
-        this->on_vertical_swing_change(*value);
+        this->on_vertical_swing_change(index);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_HORIZONTAL_SWING_SELECT
 void GreeAC::set_horizontal_swing_select(select::Select *horizontal_swing_select)
 {
     this->horizontal_swing_select_ = horizontal_swing_select;
     this->horizontal_swing_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->horizontal_swing_select_->at(index);
-        if (!value.has_value() || *value == this->horizontal_swing_state_)
+        if (index >= horizontal_swing_options::COUNT || index == this->horizontal_swing_state_)
             return;
-        this->on_horizontal_swing_change(*value);
+        this->on_horizontal_swing_change(index);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_DISPLAY_SELECT
 void GreeAC::set_display_select(select::Select *display_select)
 {
     this->display_select_ = display_select;
     this->display_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->display_select_->at(index);
-        if (!value.has_value() || *value == this->display_state_)
+        if (index >= display_options::COUNT || index == this->display_state_)
             return;
-        this->on_display_change(*value);
+        this->on_display_change(index);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
 void GreeAC::set_display_unit_select(select::Select *display_unit_select)
 {
     this->display_unit_select_ = display_unit_select;
     this->display_unit_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->display_unit_select_->at(index);
-        if (!value.has_value() || *value == this->display_unit_state_)
+        if (index >= display_unit_options::COUNT || index == this->display_unit_state_)
             return;
-        this->on_display_unit_change(*value);
+        this->on_display_unit_change(index);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_LIGHT_SELECT
 void GreeAC::set_light_select(select::Select *light_select)
 {
     this->light_select_ = light_select;
     this->light_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->light_select_->at(index);
-        if (!value.has_value() || *value == this->light_mode_)
+        if (index >= light_options::COUNT || index == this->light_mode_)
             return;
-        this->on_light_mode_change(*value);
+        this->on_light_mode_change(index);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_IONIZER_SWITCH
 void GreeAC::set_ionizer_switch(switch_::Switch *ionizer_switch)
 {
     this->ionizer_switch_ = ionizer_switch;
@@ -452,7 +556,9 @@ void GreeAC::set_ionizer_switch(switch_::Switch *ionizer_switch)
         this->on_ionizer_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_BEEPER_SWITCH
 void GreeAC::set_beeper_switch(switch_::Switch *beeper_switch)
 {
     this->beeper_switch_ = beeper_switch;
@@ -462,7 +568,9 @@ void GreeAC::set_beeper_switch(switch_::Switch *beeper_switch)
         this->on_beeper_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_SLEEP_SWITCH
 void GreeAC::set_sleep_switch(switch_::Switch *sleep_switch)
 {
     this->sleep_switch_ = sleep_switch;
@@ -472,7 +580,9 @@ void GreeAC::set_sleep_switch(switch_::Switch *sleep_switch)
         this->on_sleep_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_XFAN_SWITCH
 void GreeAC::set_xfan_switch(switch_::Switch *xfan_switch)
 {
     this->xfan_switch_ = xfan_switch;
@@ -482,7 +592,9 @@ void GreeAC::set_xfan_switch(switch_::Switch *xfan_switch)
         this->on_xfan_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
 void GreeAC::set_powersave_switch(switch_::Switch *powersave_switch)
 {
     this->powersave_switch_ = powersave_switch;
@@ -492,7 +604,9 @@ void GreeAC::set_powersave_switch(switch_::Switch *powersave_switch)
         this->on_powersave_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_TURBO_SWITCH
 void GreeAC::set_turbo_switch(switch_::Switch *turbo_switch)
 {
     this->turbo_switch_ = turbo_switch;
@@ -502,7 +616,9 @@ void GreeAC::set_turbo_switch(switch_::Switch *turbo_switch)
         this->on_turbo_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_IFEEL_SWITCH
 void GreeAC::set_ifeel_switch(switch_::Switch *ifeel_switch)
 {
     this->ifeel_switch_ = ifeel_switch;
@@ -512,52 +628,501 @@ void GreeAC::set_ifeel_switch(switch_::Switch *ifeel_switch)
         this->on_ifeel_change(state);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_ENABLE_TX_SWITCH
 void GreeAC::set_enable_tx_switch(switch_::Switch *enable_tx_switch)
 {
     this->enable_tx_switch_ = enable_tx_switch;
 }
+#endif
 
+#ifndef GREE_AC_NO_DUMP_PACKETS_SWITCH
 void GreeAC::set_dump_packets_switch(switch_::Switch *dump_packets_switch)
 {
     this->dump_packets_switch_ = dump_packets_switch;
 }
+#endif
 
+#ifndef GREE_AC_NO_QUIET_SELECT
 void GreeAC::set_quiet_select(select::Select *quiet_select)
 {
     this->quiet_select_ = quiet_select;
     this->quiet_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->quiet_select_->at(index);
-        if (!value.has_value() || *value == this->quiet_state_)
+        if (index >= quiet_options::COUNT || index == this->quiet_state_)
             return;
-        this->on_quiet_change(*value);
+        this->on_quiet_change(index);
     });
 }
+#endif
 
+#ifndef GREE_AC_NO_MODEL_ID_TEXT_SENSOR
 void GreeAC::set_model_id_text_sensor(text_sensor::TextSensor *model_id_text_sensor)
 {
     this->model_id_text_sensor_ = model_id_text_sensor;
 }
+#endif
+
+void GreeAC::set_state_snapshot_text_sensor(text_sensor::TextSensor *state_snapshot_text_sensor)
+{
+    this->state_snapshot_text_sensor_ = state_snapshot_text_sensor;
+}
+
+void GreeAC::set_loop_time_sensors(LoopPhase_t phase, sensor::Sensor *max_sensor, sensor::Sensor *avg_sensor)
+{
+    this->loop_time_max_sensors_[phase] = max_sensor;
+    this->loop_time_avg_sensors_[phase] = avg_sensor;
+}
+
+void GreeAC::set_confirm_latency_sensors(sensor::Sensor *p50_sensor, sensor::Sensor *p95_sensor, sensor::Sensor *max_sensor)
+{
+    this->confirm_latency_p50_sensor_ = p50_sensor;
+    this->confirm_latency_p95_sensor_ = p95_sensor;
+    this->confirm_latency_max_sensor_ = max_sensor;
+}
+
+/*
+ * Entity publishing
+ */
+
+void GreeAC::mark_stale_entities_(uint32_t now)
+{
+    if (this->publish_heartbeat_ms_ == 0)
+        return;
+
+    for (uint8_t entity = 0; entity < PUBLISH_COUNT; entity++) {
+        if (now - this->last_published_[entity] >= this->publish_heartbeat_ms_) {
+            this->publish_pending_ |= (1 << entity);
+            this->publish_forced_ |= (1 << entity);
+        }
+    }
+}
+
+bool GreeAC::publish_pending_entities_()
+{
+    uint32_t now = this->now_();
+    uint8_t published = 0;
+
+    /* lowest bit first, so the climate entity always goes out before selects and switches */
+    for (uint8_t entity = 0; entity < PUBLISH_COUNT; entity++) {
+        uint16_t bit = 1 << entity;
+        if ((this->publish_pending_ & bit) == 0)
+            continue;
+
+        bool force = (this->publish_forced_ & bit) != 0;
+
+        /* rate limit: keep it pending, the latest state goes out once the interval is over */
+        if (!force && now - this->last_published_[entity] < this->publish_min_interval_ms_)
+            continue;
+
+        /* at least one per pass, otherwise a loop which is always over budget would never publish */
+        if (published >= this->publish_batch_size_ || (published > 0 && this->loop_budget_exceeded_()))
+            break;
+
+        this->publish_pending_ &= ~bit;
+        this->publish_forced_ &= ~bit;
+        /* a skipped (unchanged) entity counts as fresh as well, otherwise the heartbeat would retry it every loop */
+        this->last_published_[entity] = now;
+        if (this->publish_entity_((PublishEntity_t) entity, force)) {
+            this->trace_(TRACE_PUBLISH, entity);
+            published++;
+        }
+    }
+
+    return published > 0;
+}
+
+bool GreeAC::publish_entity_(PublishEntity_t entity, bool force)
+{
+    (void) force;  /* unused when every select is excluded */
+    switch (entity) {
+        case PUBLISH_CLIMATE:
+            this->publish_state();
+            return true;
+        case PUBLISH_SNAPSHOT:
+            return this->publish_snapshot_();
+#ifndef GREE_AC_NO_VERTICAL_SWING_SELECT
+        case PUBLISH_VERTICAL_SWING:
+            return this->publish_select_(this->vertical_swing_select_, this->vertical_swing_state_, force);
+#endif
+#ifndef GREE_AC_NO_HORIZONTAL_SWING_SELECT
+        case PUBLISH_HORIZONTAL_SWING:
+            return this->publish_select_(this->horizontal_swing_select_, this->horizontal_swing_state_, force);
+#endif
+#ifndef GREE_AC_NO_DISPLAY_SELECT
+        case PUBLISH_DISPLAY:
+            return this->publish_select_(this->display_select_, this->display_state_, force);
+#endif
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
+        case PUBLISH_DISPLAY_UNIT:
+            return this->publish_select_(this->display_unit_select_, this->display_unit_state_, force);
+#endif
+#ifndef GREE_AC_NO_LIGHT_SELECT
+        case PUBLISH_LIGHT:
+            return this->publish_select_(this->light_select_, this->light_mode_, force);
+#endif
+#ifndef GREE_AC_NO_QUIET_SELECT
+        case PUBLISH_QUIET:
+            return this->publish_select_(this->quiet_select_, this->quiet_state_, force);
+#endif
+#ifndef GREE_AC_NO_IONIZER_SWITCH
+        case PUBLISH_IONIZER:
+            return this->publish_switch_(this->ionizer_switch_, this->ionizer_state_);
+#endif
+#ifndef GREE_AC_NO_BEEPER_SWITCH
+        case PUBLISH_BEEPER:
+            return this->publish_switch_(this->beeper_switch_, this->beeper_state_);
+#endif
+#ifndef GREE_AC_NO_SLEEP_SWITCH
+        case PUBLISH_SLEEP:
+            return this->publish_switch_(this->sleep_switch_, this->sleep_state_);
+#endif
+#ifndef GREE_AC_NO_XFAN_SWITCH
+        case PUBLISH_XFAN:
+            return this->publish_switch_(this->xfan_switch_, this->xfan_state_);
+#endif
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
+        case PUBLISH_POWERSAVE:
+            return this->publish_switch_(this->powersave_switch_, this->powersave_state_);
+#endif
+#ifndef GREE_AC_NO_TURBO_SWITCH
+        case PUBLISH_TURBO:
+            return this->publish_switch_(this->turbo_switch_, this->turbo_state_);
+#endif
+#ifndef GREE_AC_NO_IFEEL_SWITCH
+        case PUBLISH_IFEEL:
+            return this->publish_switch_(this->ifeel_switch_, this->ifeel_state_);
+#endif
+        default:
+            return false;
+    }
+}
+
+/* the selects are built from the option tables in the same order, so the state index is the select index */
+bool GreeAC::publish_select_(select::Select *select, uint8_t index, bool force)
+{
+    if (select == nullptr || index == OPTION_NONE)
+        return false;
+
+    if (force || !this->select_shows_(select, index)) {
+        select->publish_state((size_t) index);
+        return true;
+    }
+    return false;
+}
+
+bool GreeAC::select_shows_(select::Select *select, uint8_t index)
+{
+    auto active = select->active_index();
+    return active.has_value() && *active == index;
+}
+
+bool GreeAC::publish_switch_(switch_::Switch *sw, bool state)
+{
+    if (sw == nullptr)
+        return false;
+
+    sw->publish_state(state);
+    return true;
+}
+
+/*
+ * State snapshot - the whole decoded state plus link statistics in one message, see README for the keys
+ */
+
+/* JSON has no NaN, the temperatures are null until the first report */
+static void snapshot_temperature(char *buf, size_t size, float value)
+{
+    if (std::isfinite(value))
+        snprintf(buf, size, "%.1f", value);
+    else
+        snprintf(buf, size, "null");
+}
+
+/* printf into buf after the len bytes already there, never past size */
+static void snapshot_append(char *buf, size_t size, size_t *len, const char *format, ...)
+{
+    if (*len >= size)
+        return;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buf + *len, size - *len, format, args);
+    va_end(args);
+    if (written > 0)
+        *len += (size_t) written;
+}
+
+bool GreeAC::publish_snapshot_()
+{
+    if (this->state_snapshot_text_sensor_ == nullptr)
+        return false;
+
+    /* "lm" and "q" are the option indexes: 0 off, 1 on, 2 auto */
+    uint8_t light_mode = this->light_mode_ < light_options::COUNT ? this->light_mode_ : (uint8_t) light_options::AUTO;
+    uint8_t quiet = this->quiet_state_ < quiet_options::COUNT ? this->quiet_state_ : (uint8_t) quiet_options::OFF;
+
+    char target[12];
+    char current[12];
+    snapshot_temperature(target, sizeof(target), this->target_temperature);
+    snapshot_temperature(current, sizeof(current), this->current_temperature);
+
+    /* keys of excluded entities are left out, their fields are not decoded */
+    char buf[256];
+    size_t len = 0;
+    snapshot_append(buf, sizeof(buf), &len, "{\"v\":%u,\"m\":%u,\"t\":%s,\"c\":%s,\"f\":\"%s\",\"sw\":%u,\"vs\":\"%s\",\"hs\":\"%s\"",
+                    SNAPSHOT_VERSION, (unsigned) this->mode, target, current, this->fan_mode_name_(),
+                    (unsigned) this->swing_mode,
+                    option_name(vertical_swing_options::OPTIONS, this->vertical_swing_state_),
+                    option_name(horizontal_swing_options::OPTIONS, this->horizontal_swing_state_));
+#ifndef GREE_AC_NO_DISPLAY_SELECT
+    snapshot_append(buf, sizeof(buf), &len, ",\"d\":%u", this->display_state_ == display_options::ACT);
+#endif
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
+    snapshot_append(buf, sizeof(buf), &len, ",\"u\":%u", this->display_unit_state_ == display_unit_options::DEGF);
+#endif
+    snapshot_append(buf, sizeof(buf), &len, ",\"lm\":%u,\"l\":%u,\"q\":%u", light_mode, this->light_state_, quiet);
+#ifndef GREE_AC_NO_IONIZER_SWITCH
+    snapshot_append(buf, sizeof(buf), &len, ",\"io\":%u", this->ionizer_state_);
+#endif
+#ifndef GREE_AC_NO_BEEPER_SWITCH
+    snapshot_append(buf, sizeof(buf), &len, ",\"bp\":%u", this->beeper_state_);
+#endif
+#ifndef GREE_AC_NO_SLEEP_SWITCH
+    snapshot_append(buf, sizeof(buf), &len, ",\"sl\":%u", this->sleep_state_);
+#endif
+#ifndef GREE_AC_NO_XFAN_SWITCH
+    snapshot_append(buf, sizeof(buf), &len, ",\"xf\":%u", this->xfan_state_);
+#endif
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
+    snapshot_append(buf, sizeof(buf), &len, ",\"ps\":%u", this->powersave_state_);
+#endif
+    snapshot_append(buf, sizeof(buf), &len, ",\"tb\":%u", this->turbo_state_);
+#ifndef GREE_AC_NO_IFEEL_SWITCH
+    snapshot_append(buf, sizeof(buf), &len, ",\"if\":%u", this->ifeel_state_);
+#endif
+    snapshot_append(buf, sizeof(buf), &len, ",\"rx\":%u,\"er\":%u,\"tx\":%u}", (unsigned) this->rx_frames_,
+                    (unsigned) this->rx_errors_, (unsigned) this->tx_frames_);
+
+    this->state_snapshot_text_sensor_->publish_state(buf);
+    return true;
+}
+
+/* current fan speed as index into fan_modes::OPTIONS, from the climate fan mode or the custom one */
+uint8_t GreeAC::fan_mode_index_()
+{
+    if (this->has_custom_fan_mode()) {
+        if (this->get_custom_fan_mode() == fan_modes::MIN_NAME)
+            return fan_modes::FAN_MIN;
+        if (this->get_custom_fan_mode() == fan_modes::MAX_NAME)
+            return fan_modes::FAN_MAX;
+        return fan_modes::FAN_AUTO;
+    }
+    if (!this->fan_mode.has_value())
+        return fan_modes::FAN_AUTO;
+
+    switch (*this->fan_mode) {
+        case climate::CLIMATE_FAN_LOW:
+            return fan_modes::FAN_LOW;
+        case climate::CLIMATE_FAN_MEDIUM:
+            return fan_modes::FAN_MED;
+        case climate::CLIMATE_FAN_HIGH:
+            return fan_modes::FAN_HIGH;
+        case climate::CLIMATE_FAN_AUTO:
+        default:
+            return fan_modes::FAN_AUTO;
+    }
+}
+
+/*
+ * Loop timing
+ */
+
+void GreeAC::loop_phase_record_(LoopPhase_t phase, uint32_t start_cycles)
+{
+    /* unsigned subtraction keeps this correct across cycle counter wraparound */
+    uint32_t cycles = arch_get_cpu_cycle_count() - start_cycles;
+    LoopPhaseStats_t &stats = this->loop_stats_[phase];
+
+    if (cycles > stats.max_cycles) {
+        stats.max_cycles = cycles;
+    }
+    stats.sum_cycles += cycles;
+    stats.count++;
+}
+
+bool GreeAC::loop_budget_exceeded_()
+{
+    if (this->loop_budget_cycles_ == 0) {
+        return false;
+    }
+    return (arch_get_cpu_cycle_count() - this->loop_start_cycles_) >= this->loop_budget_cycles_;
+}
+
+void GreeAC::publish_loop_stats_()
+{
+    uint32_t now = this->now_();
+    if (now - this->last_loop_stats_published_ < LOOP_STATS_PERIOD_MS) {
+        return;
+    }
+    this->last_loop_stats_published_ = now;
+
+    const float cycles_per_ms = arch_get_cpu_freq_hz() / 1000.0f;
+
+    for (uint8_t phase = 0; phase < LOOP_PHASE_COUNT; phase++) {
+        LoopPhaseStats_t &stats = this->loop_stats_[phase];
+        if (stats.count == 0) {
+            continue;
+        }
+
+        float max_ms = stats.max_cycles / cycles_per_ms;
+        float avg_ms = (float) (stats.sum_cycles / stats.count) / cycles_per_ms;
+        ESP_LOGD(TAG, "Loop %-7s max %.3f ms, avg %.3f ms (%u samples)",
+                 LOOP_PHASE_NAMES[phase], max_ms, avg_ms, (unsigned) stats.count);
+
+        if (this->loop_time_max_sensors_[phase] != nullptr) {
+            this->loop_time_max_sensors_[phase]->publish_state(max_ms);
+        }
+        if (this->loop_time_avg_sensors_[phase] != nullptr) {
+            this->loop_time_avg_sensors_[phase]->publish_state(avg_ms);
+        }
+
+        stats = {};
+    }
+}
+
+/* commands come from people and automations, so publishing on every sample is cheap enough */
+void GreeAC::note_command_confirmed_(uint32_t latency_ms)
+{
+    this->confirm_latency_.record(latency_ms);
+    ESP_LOGD(TAG, "Command confirmed by the unit after %u ms", (unsigned) latency_ms);
+
+    if (this->confirm_latency_p50_sensor_ != nullptr) {
+        this->confirm_latency_p50_sensor_->publish_state(this->confirm_latency_.percentile(50));
+    }
+    if (this->confirm_latency_p95_sensor_ != nullptr) {
+        this->confirm_latency_p95_sensor_->publish_state(this->confirm_latency_.percentile(95));
+    }
+    if (this->confirm_latency_max_sensor_ != nullptr) {
+        this->confirm_latency_max_sensor_->publish_state(this->confirm_latency_.max());
+    }
+}
 
 /*
  * Debugging
  */
 
+void GreeAC::note_sync_loss_(uint32_t bytes, uint32_t now)
+{
+    if (!this->sync_lost_) {
+        this->sync_lost_ = true;
+        this->sync_lost_since_ = now;
+        this->sync_lost_bytes_ = 0;
+    }
+    this->sync_lost_bytes_ += bytes;
+}
+
+void GreeAC::note_sync_recovered_(uint32_t now)
+{
+    if (this->sync_lost_) {
+        this->sync_recovery_.record(this->sync_lost_bytes_, now - this->sync_lost_since_);
+        this->sync_lost_ = false;
+    }
+}
+
+void GreeAC::dump_sync_stats()
+{
+    char json[256];
+    this->sync_recovery_.format_json(json, sizeof(json));
+    ESP_LOGI(TAG, "Framing recovery: %s", json);
+    if (this->sync_lost_) {
+        ESP_LOGI(TAG, "Framing currently lost for %u ms, %u bytes",
+                 (unsigned) (this->now_() - this->sync_lost_since_), (unsigned) this->sync_lost_bytes_);
+    }
+#ifdef GREE_AC_RX_TASK
+    ESP_LOGI(TAG, "RX queue: %u frames dropped", (unsigned) this->rx_queue_->dropped());
+#endif
+}
+
 void GreeAC::log_packet(const uint8_t *data, size_t len, bool outgoing)
 {
+    uint32_t now = this->now_();
+    this->recorder_.record(data, len, outgoing, now);
+
+#ifdef GREE_AC_NO_DUMP_PACKETS_SWITCH
+    /* without the switch there is no way to turn the dump on */
+    return;
+#else
     if (this->dump_packets_switch_ != nullptr && !this->dump_packets_switch_->state) {
         return;
     }
+#endif
 
 #if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
-    const char *prefix = "";
+    /* only queue the raw bytes here, formatting and logging happen in flush_packet_log_() */
+    uint8_t flags = 0;
     if (outgoing) {
-        bool tx_enabled = (this->enable_tx_switch_ == nullptr || this->enable_tx_switch_->state);
-        prefix = tx_enabled ? " TX :" : "(TX):";
-    } else {
-        prefix = " RX :";
+        flags |= PacketLogQueue::FLAG_TX;
+        if (this->tx_enabled_())
+            flags |= PacketLogQueue::FLAG_TX_ENABLED;
+    }
+    this->packet_log_.push(data, len, flags, now);
+#endif
+}
+
+void GreeAC::flush_packet_log_()
+{
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+    uint32_t dropped = this->packet_log_.take_dropped();
+    if (dropped > 0) {
+        ESP_LOGW(TAG, "Packet dump fell behind, %u packets dropped", (unsigned) dropped);
+    }
+
+    uint8_t record[CAPTURE_HEADER_LEN + 0xFF];
+    uint8_t *data = &record[CAPTURE_HEADER_LEN];
+    uint8_t flags;
+    uint32_t time;
+    size_t len = this->packet_log_.pop(data, 0xFF, &flags, &time);
+    if (len == 0) {
+        return;
+    }
+
+    if (this->packet_dump_capture_) {
+        /* frames which were suppressed by the TX switch never made it onto the wire */
+        if ((flags & PacketLogQueue::FLAG_TX) && !(flags & PacketLogQueue::FLAG_TX_ENABLED)) {
+            return;
+        }
+
+        for (uint8_t i = 0; i < 4; i++)
+            record[i] = (time >> (8 * i)) & 0xFF;
+        record[4] = (flags & PacketLogQueue::FLAG_TX) ? CAPTURE_DIR_TO_UNIT : CAPTURE_DIR_FROM_UNIT;
+        record[5] = len;
+
+        /* records longer than one line continue on "GCAP+" lines, sniffer/gcap.py joins them again */
+        size_t record_len = CAPTURE_HEADER_LEN + len;
+        char line[PACKET_LOG_CHUNK * 2 + 1];
+        for (size_t start = 0; start < record_len; start += PACKET_LOG_CHUNK) {
+            size_t chunk = (record_len - start < PACKET_LOG_CHUNK) ? record_len - start : PACKET_LOG_CHUNK;
+            format_hex_dotted(line, sizeof(line), &record[start], chunk, '\0');
+            ESP_LOGD(TAG, "%s %s", start == 0 ? "GCAP" : "GCAP+", line);
+        }
+        return;
+    }
+
+    const char *prefix = " RX :";
+    if (flags & PacketLogQueue::FLAG_TX) {
+        prefix = (flags & PacketLogQueue::FLAG_TX_ENABLED) ? " TX :" : "(TX):";
+    }
+
+    char line[PACKET_LOG_CHUNK * 3];
+    for (size_t start = 0; start < len; start += PACKET_LOG_CHUNK) {
+        size_t chunk = (len - start < PACKET_LOG_CHUNK) ? len - start : PACKET_LOG_CHUNK;
+        format_hex_dotted(line, sizeof(line), &data[start], chunk);
+        if (start == 0) {
+            ESP_LOGD(TAG, "%s %s (%u)", prefix, line, (unsigned) len);
+        } else {
+            ESP_LOGD(TAG, "      %s", line);
+        }
     }
-    ESP_LOGD(TAG, "%s %s", prefix, format_hex_pretty(data, len).c_str());
 #endif
 }
 
@@ -8,156 +8,243 @@
 #include "esphome/components/switch/switch.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "gree_ac_options.h"
+#include "gree_ac_protocol.h"
+#include "gree_ac_recorder.h"
+
+#ifdef GREE_AC_RX_TASK
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
 
 namespace esphome {
 
 namespace gree_ac {
 
 
-namespace fan_modes{
-    const char* const FAN_AUTO  = "Auto";
-    const char* const FAN_MIN   = "Minimum";
-    const char* const FAN_LOW   = "Low";
-    const char* const FAN_MED   = "Medium";
-    const char* const FAN_HIGH  = "High";
-    const char* const FAN_MAX   = "Maximum";
-}
-
-/* this must be same as QUIET_OPTIONS in climate.py */
-namespace quiet_options{
-    const char* const OFF   = "Off";
-    const char* const ON    = "On";
-    const char* const AUTO  = "Auto";
-}
-
-/* this must be same as HORIZONTAL_SWING_OPTIONS in climate.py */
-namespace horizontal_swing_options{
-    const char* const OFF    = "Off";
-    const char* const FULL   = "Swing - Full";
-    const char* const CLEFT  = "Constant - Left";
-    const char* const CMIDL  = "Constant - Mid-Left";
-    const char* const CMID   = "Constant - Middle";
-    const char* const CMIDR  = "Constant - Mid-Right";
-    const char* const CRIGHT = "Constant - Right";
-}
-
-/* this must be same as VERTICAL_SWING_OPTIONS in climate.py */
-namespace vertical_swing_options{
-    const char* const OFF   = "Off";
-    const char* const FULL  = "Swing - Full";
-    const char* const DOWN  = "Swing - Down";
-    const char* const MIDD  = "Swing - Mid-Down";
-    const char* const MID   = "Swing - Middle";
-    const char* const MIDU  = "Swing - Mid-Up";
-    const char* const UP    = "Swing - Up";
-    const char* const CDOWN = "Constant - Down";
-    const char* const CMIDD = "Constant - Mid-Down";
-    const char* const CMID  = "Constant - Middle";
-    const char* const CMIDU = "Constant - Mid-Up";
-    const char* const CUP   = "Constant - Up";
-}
-
-/* this must be same as DISPLAY_OPTIONS in climate.py */
-namespace display_options{
-    const char* const SET  = "Set temperature";
-    const char* const ACT  = "Actual temperature";
-}
-
-/* this must be same as DISPLAY_UNIT_OPTIONS in climate.py */
-namespace display_unit_options{
-    const char* const DEGC = "C";
-    const char* const DEGF = "F";
-}
-
-/* this must be same as LIGHT_OPTIONS in climate.py */
-namespace light_options{
-    const char* const OFF   = "Off";
-    const char* const ON    = "On";
-    const char* const AUTO  = "Auto";
-}
-
+/* phases of a single loop() pass, timed with the CPU cycle counter */
+typedef enum {
+        LOOP_PHASE_INGEST,
+        LOOP_PHASE_VERIFY,
+        LOOP_PHASE_DECODE,
+        LOOP_PHASE_PUBLISH,
+        LOOP_PHASE_ENCODE,
+        LOOP_PHASE_TX,
+        LOOP_PHASE_TOTAL,
+        LOOP_PHASE_COUNT
+} LoopPhase_t;
+
+/* entities published from the loop, in publishing priority order */
 typedef enum {
-        STATE_WAIT_SYNC,
-        STATE_RECIEVE,
-        STATE_COMPLETE,
-        STATE_RESTART
-} SerialProcessState_t;
+        PUBLISH_CLIMATE,
+        PUBLISH_SNAPSHOT,
+        PUBLISH_VERTICAL_SWING,
+        PUBLISH_HORIZONTAL_SWING,
+        PUBLISH_DISPLAY,
+        PUBLISH_DISPLAY_UNIT,
+        PUBLISH_LIGHT,
+        PUBLISH_QUIET,
+        PUBLISH_IONIZER,
+        PUBLISH_BEEPER,
+        PUBLISH_SLEEP,
+        PUBLISH_XFAN,
+        PUBLISH_POWERSAVE,
+        PUBLISH_TURBO,
+        PUBLISH_IFEEL,
+        PUBLISH_COUNT
+} PublishEntity_t;
+
+/* time source for all protocol timing, see GreeAC::set_clock() */
+typedef uint32_t (*ClockFn_t)();
 
 typedef struct {
-  uint8_t data[200];
-  size_t size;
-  uint8_t frame_size;
-  SerialProcessState_t state;
-  uint32_t last_byte_time;
-} SerialProcess_t;
+  uint32_t max_cycles;
+  uint64_t sum_cycles;
+  uint32_t count;
+} LoopPhaseStats_t;
 
 class GreeAC : public Component, public uart::UARTDevice, public climate::Climate {
     public:
+        /* entities listed in exclude_entities are compiled out with GREE_AC_NO_<entity>, see climate.py */
+#ifndef GREE_AC_NO_VERTICAL_SWING_SELECT
         void set_vertical_swing_select(select::Select *vertical_swing_select);
+#endif
+#ifndef GREE_AC_NO_HORIZONTAL_SWING_SELECT
         void set_horizontal_swing_select(select::Select *horizontal_swing_select);
+#endif
 
+#ifndef GREE_AC_NO_DISPLAY_SELECT
         void set_display_select(select::Select *display_select);
+#endif
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
         void set_display_unit_select(select::Select *display_unit_select);
+#endif
 
+#ifndef GREE_AC_NO_LIGHT_SELECT
         void set_light_select(select::Select *light_select);
+#endif
+#ifndef GREE_AC_NO_IONIZER_SWITCH
         void set_ionizer_switch(switch_::Switch *ionizer_switch);
+#endif
+#ifndef GREE_AC_NO_BEEPER_SWITCH
         void set_beeper_switch(switch_::Switch *beeper_switch);
+#endif
+#ifndef GREE_AC_NO_SLEEP_SWITCH
         void set_sleep_switch(switch_::Switch *sleep_switch);
+#endif
+#ifndef GREE_AC_NO_XFAN_SWITCH
         void set_xfan_switch(switch_::Switch *xfan_switch);
+#endif
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
         void set_powersave_switch(switch_::Switch *powersave_switch);
+#endif
+#ifndef GREE_AC_NO_TURBO_SWITCH
         void set_turbo_switch(switch_::Switch *turbo_switch);
+#endif
+#ifndef GREE_AC_NO_IFEEL_SWITCH
         void set_ifeel_switch(switch_::Switch *ifeel_switch);
+#endif
+#ifndef GREE_AC_NO_ENABLE_TX_SWITCH
         void set_enable_tx_switch(switch_::Switch *enable_tx_switch);
+#endif
+#ifndef GREE_AC_NO_DUMP_PACKETS_SWITCH
         void set_dump_packets_switch(switch_::Switch *dump_packets_switch);
+#endif
 
+#ifndef GREE_AC_NO_QUIET_SELECT
         void set_quiet_select(select::Select *quiet_select);
+#endif
 
+#ifndef GREE_AC_NO_MODEL_ID_TEXT_SENSOR
         void set_model_id_text_sensor(text_sensor::TextSensor *model_id_text_sensor);
+#endif
+        void set_state_snapshot_text_sensor(text_sensor::TextSensor *state_snapshot_text_sensor);
+
+        void set_loop_time_sensors(LoopPhase_t phase, sensor::Sensor *max_sensor, sensor::Sensor *avg_sensor);
+        void set_confirm_latency_sensors(sensor::Sensor *p50_sensor, sensor::Sensor *p95_sensor, sensor::Sensor *max_sensor);
+        void set_loop_budget(uint32_t budget_us) { this->loop_budget_us_ = budget_us; }
+        void set_publish_batch_size(uint8_t batch_size) { this->publish_batch_size_ = batch_size; }
+        void set_publish_min_interval(uint32_t interval_ms) { this->publish_min_interval_ms_ = interval_ms; }
+        void set_publish_heartbeat(uint32_t heartbeat_ms) { this->publish_heartbeat_ms_ = heartbeat_ms; }
+        void set_current_temperature_deadband(float deadband) { this->current_temperature_deadband_ = deadband; }
+        void set_flight_recorder_size(uint16_t size) { this->flight_recorder_size_ = size; }
+        void set_packet_dump_capture(bool capture) { this->packet_dump_capture_ = capture; }
+        /* replaces millis() for every timeout and period of the component, so a harness can run simulated time */
+        void set_clock(ClockFn_t clock) { this->clock_ = clock; }
+        void set_clock_offset(uint32_t offset_ms) { this->clock_offset_ = offset_ms; }
+
+        void dump_flight_recorder() { this->recorder_.dump(); }
+        void dump_sync_stats();
+        void set_trace_buffer_size(uint16_t entries) { this->trace_buffer_size_ = entries; }
+        void dump_trace() { this->tracer_.dump(); }
 
         void setup() override;
         void loop() override;
         void dump_config() override;
 
     protected:
+#ifndef GREE_AC_NO_VERTICAL_SWING_SELECT
         select::Select *vertical_swing_select_   = nullptr; /* Advanced vertical swing select */
+#endif
+#ifndef GREE_AC_NO_HORIZONTAL_SWING_SELECT
         select::Select *horizontal_swing_select_ = nullptr; /* Advanced horizontal swing select */
+#endif
 
+#ifndef GREE_AC_NO_DISPLAY_SELECT
         select::Select *display_select_          = nullptr; /* Select for setting display mode */
+#endif
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
         select::Select *display_unit_select_     = nullptr; /* Select for setting display temperature unit */
+#endif
 
+#ifndef GREE_AC_NO_LIGHT_SELECT
         select::Select *light_select_            = nullptr; /* Select for light */
+#endif
+#ifndef GREE_AC_NO_IONIZER_SWITCH
         switch_::Switch *ionizer_switch_         = nullptr; /* Switch for ionizer */
+#endif
+#ifndef GREE_AC_NO_BEEPER_SWITCH
         switch_::Switch *beeper_switch_          = nullptr; /* Switch for beeper */
+#endif
+#ifndef GREE_AC_NO_SLEEP_SWITCH
         switch_::Switch *sleep_switch_           = nullptr; /* Switch for sleep */
+#endif
+#ifndef GREE_AC_NO_XFAN_SWITCH
         switch_::Switch *xfan_switch_            = nullptr; /* Switch for X-fan */
+#endif
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
         switch_::Switch *powersave_switch_       = nullptr; /* Switch for powersave */
+#endif
+#ifndef GREE_AC_NO_TURBO_SWITCH
         switch_::Switch *turbo_switch_           = nullptr; /* Switch for turbo */
+#endif
+#ifndef GREE_AC_NO_IFEEL_SWITCH
         switch_::Switch *ifeel_switch_           = nullptr; /* Switch for I-Feel */
+#endif
+#ifndef GREE_AC_NO_ENABLE_TX_SWITCH
         switch_::Switch *enable_tx_switch_      = nullptr; /* Switch for enabling TX */
+#endif
+#ifndef GREE_AC_NO_DUMP_PACKETS_SWITCH
         switch_::Switch *dump_packets_switch_   = nullptr; /* Switch for dumping packets */
+#endif
 
+#ifndef GREE_AC_NO_QUIET_SELECT
         select::Select *quiet_select_            = nullptr; /* Select for quiet mode */
+#endif
 
+#ifndef GREE_AC_NO_MODEL_ID_TEXT_SENSOR
         text_sensor::TextSensor *model_id_text_sensor_ = nullptr; /* Text sensor for Model ID */
-
-        std::string vertical_swing_state_;
-        std::string horizontal_swing_state_;
-
-        std::string display_state_;
-        std::string display_unit_state_;
-        std::string quiet_state_;
-        std::string light_mode_;
-
-        bool light_state_;
-        bool ionizer_state_;
-        bool beeper_state_;
-        bool sleep_state_;
-        bool xfan_state_;
-        bool powersave_state_;
-        bool turbo_state_;
-        bool ifeel_state_;
+#endif
+        text_sensor::TextSensor *state_snapshot_text_sensor_ = nullptr; /* Text sensor with the whole state as JSON */
+
+        sensor::Sensor *loop_time_max_sensors_[LOOP_PHASE_COUNT] = {}; /* Max duration of each loop phase */
+        sensor::Sensor *loop_time_avg_sensors_[LOOP_PHASE_COUNT] = {}; /* Average duration of each loop phase */
+        sensor::Sensor *confirm_latency_p50_sensor_ = nullptr; /* Median time from a command to its confirmation */
+        sensor::Sensor *confirm_latency_p95_sensor_ = nullptr; /* 95th percentile of the same */
+        sensor::Sensor *confirm_latency_max_sensor_ = nullptr; /* Longest confirmation since boot */
+
+        /* The members below hold the latest decoded state, the entities keep the last published one.
+           Bits in publish_pending_ mark entities which still have to catch up. */
+        /* select states are indexes into the option tables of gree_ac_options.h */
+        uint8_t vertical_swing_state_ = OPTION_NONE;
+        uint8_t horizontal_swing_state_ = OPTION_NONE;
+
+        uint8_t display_state_ = OPTION_NONE;
+        uint8_t display_unit_state_ = OPTION_NONE;
+        uint8_t quiet_state_ = OPTION_NONE;
+        uint8_t light_mode_ = OPTION_NONE;
+
+        bool light_state_ = false;
+        bool ionizer_state_ = false;
+        bool beeper_state_ = false;
+        bool sleep_state_ = false;
+        bool xfan_state_ = false;
+        bool powersave_state_ = false;
+        bool turbo_state_ = false;
+        bool ifeel_state_ = false;
 
         SerialProcess_t serialProcess_;
+        HighFrequencyLoopRequester high_freq_;  /* held only around frames, see GreeACCNT::loop() */
+
+#ifdef GREE_AC_RX_TASK
+        /* rx_task: the task owns the UART receive side, loop() only takes complete frames off rx_queue_ */
+        FrameQueue *rx_queue_ = nullptr;
+        TaskHandle_t rx_task_handle_ = nullptr;
+        bool rx_checksum_ok_ = false;        /* checksum of the frame in serialProcess_, as found by the task */
+        uint32_t rx_dropped_logged_ = 0;     /* rx_queue_->dropped() at the last warning */
+        static void rx_task_(void *arg);
+        bool take_queued_frame_();
+#endif
+
+        FlightRecorder recorder_;            /* last frames on the bus, see dump_flight_recorder() */
+        PacketLogQueue packet_log_;          /* frames waiting for flush_packet_log_() */
+        uint16_t flight_recorder_size_ = 1024;
+        TraceRing tracer_;                   /* latency trace points, see dump_trace() */
+        uint16_t trace_buffer_size_ = 128;
+        bool packet_dump_capture_ = false;   /* dump packets as GCAP records instead of text */
 
         uint32_t init_time_;   // Stores the current time
         // uint32_t last_read_;   // Stores the time at which the last read was done
@@ -166,18 +253,53 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         uint32_t last_packet_received_;  // Stores the time at which the last packet was received
         bool wait_response_;
 
+        ClockFn_t clock_ = &millis;
+        uint32_t clock_offset_ = 0;  // added to the clock, to reach the 32 bit wraparound without waiting 49 days
+        uint32_t now_() { return this->clock_() + this->clock_offset_; }
+
+        /* link statistics */
+        uint32_t rx_frames_ = 0;     // valid frames received
+        uint32_t rx_errors_ = 0;     // frames dropped by verification
+        uint32_t tx_frames_ = 0;     // frames sent
+
+        /* framing recovery, from the first byte lost to the next valid frame */
+        RecoveryStats sync_recovery_;
+        bool sync_lost_ = false;
+        uint32_t sync_lost_since_ = 0;
+        uint32_t sync_lost_bytes_ = 0;
+
+        /* control() / select / switch change until the first unit report showing it */
+        LatencyHistogram confirm_latency_;
+        uint32_t confirm_timeouts_ = 0;
+
+        LoopPhaseStats_t loop_stats_[LOOP_PHASE_COUNT] = {};
+        uint32_t loop_budget_us_ = 0;          // 0 = no budget, never defer
+        uint32_t loop_budget_cycles_ = 0;
+        uint32_t loop_start_cycles_ = 0;       // cycle counter at the start of the current loop()
+        uint32_t last_loop_stats_published_ = 0;
+
+        uint16_t publish_pending_ = 0;         // bit per PublishEntity_t
+        uint16_t publish_forced_ = 0;          // pending bits which must be published even if unchanged
+        uint8_t publish_batch_size_ = 3;       // max entities published per loop()
+        uint32_t publish_min_interval_ms_ = 0; // min time between two publishes of the same entity
+        uint32_t publish_heartbeat_ms_ = 0;    // republish entities older than this, 0 = never
+        float current_temperature_deadband_ = 0;
+        uint32_t last_published_[PUBLISH_COUNT] = {};
+
         climate::ClimateTraits traits() override;
+        climate::ClimateTraits traits_;
+        bool traits_built_ = false;
 
         bool update_current_temperature(float temperature);
         bool update_target_temperature(float temperature);
 
-        bool update_swing_horizontal(const std::string &swing);
-        bool update_swing_vertical(const std::string &swing);
+        bool update_swing_horizontal(uint8_t swing);
+        bool update_swing_vertical(uint8_t swing);
 
-        bool update_display(const std::string &display);
-        bool update_display_unit(const std::string &display_unit);
+        bool update_display(uint8_t display);
+        bool update_display_unit(uint8_t display_unit);
 
-        bool update_fan_mode(const std::string &fan_mode);
+        bool update_fan_mode(uint8_t fan_mode);
         bool update_light(bool light);
         bool update_ionizer(bool ionizer);
         bool update_beeper(bool beeper);
@@ -186,15 +308,15 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         bool update_powersave(bool powersave);
         bool update_turbo(bool turbo);
         bool update_ifeel(bool ifeel);
-        bool update_quiet(const std::string &quiet);
+        bool update_quiet(uint8_t quiet);
 
-        virtual void on_horizontal_swing_change(const std::string &swing) = 0;
-        virtual void on_vertical_swing_change(const std::string &swing) = 0;
+        virtual void on_horizontal_swing_change(uint8_t swing) = 0;
+        virtual void on_vertical_swing_change(uint8_t swing) = 0;
 
-        virtual void on_display_change(const std::string &display) = 0;
-        virtual void on_display_unit_change(const std::string &display_unit) = 0;
+        virtual void on_display_change(uint8_t display) = 0;
+        virtual void on_display_unit_change(uint8_t display_unit) = 0;
 
-        virtual void on_light_mode_change(const std::string &mode) = 0;
+        virtual void on_light_mode_change(uint8_t mode) = 0;
         virtual void on_ionizer_change(bool ionizer) = 0;
         virtual void on_beeper_change(bool beeper) = 0;
         virtual void on_sleep_change(bool sleep) = 0;
@@ -202,11 +324,49 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         virtual void on_powersave_change(bool powersave) = 0;
         virtual void on_turbo_change(bool turbo) = 0;
         virtual void on_ifeel_change(bool ifeel) = 0;
-        virtual void on_quiet_change(const std::string &quiet) = 0;
+        virtual void on_quiet_change(uint8_t quiet) = 0;
 
         climate::ClimateAction determine_action();
 
         void log_packet(const uint8_t *data, size_t len, bool outgoing = false);
+        void flush_packet_log_();
+
+        void mark_for_publish_(PublishEntity_t entity) { this->publish_pending_ |= (1 << entity); }
+        void mark_stale_entities_(uint32_t now);
+        bool publish_pending_entities_();
+        bool publish_entity_(PublishEntity_t entity, bool force);
+        bool publish_select_(select::Select *select, uint8_t index, bool force);
+        bool select_shows_(select::Select *select, uint8_t index);
+        bool publish_switch_(switch_::Switch *sw, bool state);
+        bool tx_enabled_()
+        {
+#ifndef GREE_AC_NO_ENABLE_TX_SWITCH
+            return this->enable_tx_switch_ == nullptr || this->enable_tx_switch_->state;
+#else
+            return true;
+#endif
+        }
+        /* a frame is between its first sync byte and being handled */
+        bool rx_in_flight_()
+        {
+#ifdef GREE_AC_RX_TASK
+            return this->rx_queue_->front() != nullptr;
+#else
+            return this->serialProcess_.size > 0;
+#endif
+        }
+        bool publish_snapshot_();
+        uint8_t fan_mode_index_();
+        const char *fan_mode_name_() { return fan_modes::OPTIONS[this->fan_mode_index_()].name; }
+
+        void trace_(TracePoint_t point, uint8_t arg = 0) { this->tracer_.record(point, arg, micros()); }
+        void note_sync_loss_(uint32_t bytes, uint32_t now);
+        void note_sync_recovered_(uint32_t now);
+        void note_command_confirmed_(uint32_t latency_ms);
+
+        void loop_phase_record_(LoopPhase_t phase, uint32_t start_cycles);
+        bool loop_budget_exceeded_();
+        void publish_loop_stats_();
 
     protected:
         static const char *const VERSION;
@@ -216,7 +376,8 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         static const float TEMPERATURE_STEP;
         static const float TEMPERATURE_TOLERANCE;
         static const uint8_t TEMPERATURE_THRESHOLD;
-        static const uint8_t DATA_MAX;
+        static const uint32_t LOOP_STATS_PERIOD_MS;
+        static const uint8_t SNAPSHOT_VERSION;
 };
 
 }  // namespace gree_ac
@@ -0,0 +1,272 @@
+#include "gree_ac_cnt.h"
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include <cstring>
+
+#ifdef GREE_AC_FOOTPRINT_REPORT
+#if defined(USE_ESP8266)
+#include <Esp.h>
+#elif defined(USE_ESP32)
+#include <esp_heap_caps.h>
+#endif
+#endif
+
+namespace esphome {
+namespace gree_ac {
+namespace CNT {
+
+static const char *const TAG = "gree_ac.bench";
+
+/* bits flipped by the "all fields changed" decode case, every decoded field except mode, power and the
+   select fields of next_option(); each flip keeps the field a value the decoder knows */
+static const FieldMask_t ALL_FIELDS_FLIP[] PROGMEM = {
+    {protocol::REPORT_TEMP_SET_BYTE,   0x10},  /* +-1 degree */
+    {protocol::REPORT_TEMP_ACT_BYTE,   0x01},
+    {protocol::REPORT_DISP_ON_BYTE,    protocol::REPORT_DISP_ON_MASK},
+    {protocol::REPORT_DISP_F_BYTE,     protocol::REPORT_DISP_F_MASK},
+    {protocol::REPORT_IONIZER1_BYTE,   protocol::REPORT_IONIZER1_MASK},
+    {protocol::REPORT_IONIZER2_BYTE,   protocol::REPORT_IONIZER2_MASK},
+    {protocol::REPORT_BEEPER_BYTE,     protocol::REPORT_BEEPER_MASK},
+    {protocol::REPORT_SLEEP_BYTE,      protocol::REPORT_SLEEP_MASK},
+    {protocol::REPORT_XFAN_BYTE,       protocol::REPORT_XFAN_MASK},
+    {protocol::REPORT_POWERSAVE_BYTE,  protocol::REPORT_POWERSAVE_MASK},
+    {protocol::REPORT_FAN_TURBO_BYTE,  protocol::REPORT_FAN_TURBO_MASK},
+    {protocol::REPORT_IFEEL_BYTE,      protocol::REPORT_IFEEL_MASK},
+    {protocol::REPORT_FAN_QUIET_BYTE,  protocol::REPORT_FAN_QUIET_MASK},
+    {protocol::REPORT_FAN_SPD1_BYTE,   0x01},
+};
+
+/* moves a select field of a report to the next option of its table; the tables have gaps (display mode has
+   no AUTO / OUT, horizontal swing no 7), which a plain bit flip would hit and make the decoder warn */
+template<size_t N, size_t W>
+static void next_option(uint8_t *report, uint8_t byte, uint8_t mask, uint8_t pos, const OptionDef (&options)[N],
+                        const WireLookup<W> &from_wire)
+{
+    uint8_t index = from_wire[(report[byte] & mask) >> pos];
+    uint8_t next = index < N - 1 ? index + 1 : 0;
+    report[byte] = (report[byte] & ~mask) | (option_wire(options, next, 0) << pos);
+}
+
+/* start of one measurement */
+typedef struct {
+    uint32_t cycles;
+    uint32_t allocs;
+} BenchStart_t;
+
+static BenchStart_t bench_start(AllocCountFn_t alloc_counter)
+{
+    BenchStart_t start;
+    start.allocs = alloc_counter != nullptr ? alloc_counter() : 0;
+    start.cycles = arch_get_cpu_cycle_count();
+    return start;
+}
+
+static void log_result(const char *name, uint16_t iterations, const BenchStart_t &start, AllocCountFn_t alloc_counter,
+                       const char *version)
+{
+    uint32_t cycles = arch_get_cpu_cycle_count() - start.cycles;
+    uint32_t mhz = arch_get_cpu_freq_hz() / 1000000;
+    uint32_t ns_per_op = (uint32_t) ((uint64_t) cycles * 1000 / mhz / iterations);
+
+    /* one JSON object per line, so results can be grepped out of the log and compared between releases */
+    if (alloc_counter != nullptr) {
+        float allocs_per_op = (float) (alloc_counter() - start.allocs) / iterations;
+        ESP_LOGI(TAG, "{\"bench\":\"%s\",\"n\":%u,\"ns_op\":%u,\"allocs_op\":%.2f,\"cpu_mhz\":%u,\"v\":\"%s\"}",
+                 name, (unsigned) iterations, (unsigned) ns_per_op, allocs_per_op, (unsigned) mhz, version);
+    } else {
+        ESP_LOGI(TAG, "{\"bench\":\"%s\",\"n\":%u,\"ns_op\":%u,\"cpu_mhz\":%u,\"v\":\"%s\"}",
+                 name, (unsigned) iterations, (unsigned) ns_per_op, (unsigned) mhz, version);
+    }
+    App.feed_wdt();
+}
+
+void GreeACCNT::save_decoded_state_(DecodedState_t *state)
+{
+    state->serial = this->serialProcess_;
+    state->mode = this->mode;
+    state->target_temperature = this->target_temperature;
+    state->current_temperature = this->current_temperature;
+    state->fan_mode = this->fan_mode;
+    state->custom_fan_mode = this->has_custom_fan_mode() ? this->get_custom_fan_mode().c_str() : nullptr;
+    state->swing_mode = this->swing_mode;
+    state->mode_internal = this->mode_internal_;
+    state->power_internal = this->power_internal_;
+    state->vertical_swing = this->vertical_swing_state_;
+    state->horizontal_swing = this->horizontal_swing_state_;
+    state->display = this->display_state_;
+    state->display_unit = this->display_unit_state_;
+    state->quiet = this->quiet_state_;
+    state->light_mode = this->light_mode_;
+    state->light = this->light_state_;
+    state->ionizer = this->ionizer_state_;
+    state->beeper = this->beeper_state_;
+    state->sleep = this->sleep_state_;
+    state->xfan = this->xfan_state_;
+    state->powersave = this->powersave_state_;
+    state->turbo = this->turbo_state_;
+    state->ifeel = this->ifeel_state_;
+    state->update = this->update_;
+    state->reqmodechange = this->reqmodechange;
+    state->publish_pending = this->publish_pending_;
+    state->publish_forced = this->publish_forced_;
+}
+
+void GreeACCNT::restore_decoded_state_(const DecodedState_t &state)
+{
+    this->serialProcess_ = state.serial;
+    this->mode = state.mode;
+    this->target_temperature = state.target_temperature;
+    this->current_temperature = state.current_temperature;
+    /* the custom fan mode first, setting it may clear fan_mode */
+    this->set_custom_fan_mode_(state.custom_fan_mode != nullptr ? state.custom_fan_mode : "");
+    this->fan_mode = state.fan_mode;
+    this->swing_mode = state.swing_mode;
+    this->mode_internal_ = state.mode_internal;
+    this->power_internal_ = state.power_internal;
+    this->vertical_swing_state_ = state.vertical_swing;
+    this->horizontal_swing_state_ = state.horizontal_swing;
+    this->display_state_ = state.display;
+    this->display_unit_state_ = state.display_unit;
+    this->quiet_state_ = state.quiet;
+    this->light_mode_ = state.light_mode;
+    this->light_state_ = state.light;
+    this->ionizer_state_ = state.ionizer;
+    this->beeper_state_ = state.beeper;
+    this->sleep_state_ = state.sleep;
+    this->xfan_state_ = state.xfan;
+    this->powersave_state_ = state.powersave;
+    this->turbo_state_ = state.turbo;
+    this->ifeel_state_ = state.ifeel;
+    this->update_ = state.update;
+    this->reqmodechange = state.reqmodechange;
+    this->publish_pending_ = state.publish_pending;
+    this->publish_forced_ = state.publish_forced;
+}
+
+/*
+ * Times the RX/TX hot paths on the device itself, using the last unit report as input.
+ * The decode cases alternate between the report and a modified copy, so every pass is a change.
+ * The whole decoded state is saved first and restored before encoding, so changes the user made which are
+ * not sent yet survive the run, and nothing is published or sent because of it.
+ */
+void GreeACCNT::run_benchmarks(uint16_t iterations)
+{
+    if (iterations == 0)
+        return;
+    if (!this->has_last_report_) {
+        ESP_LOGW(TAG, "No unit report received yet, nothing to benchmark with");
+        return;
+    }
+
+    const size_t frame_len = protocol::SET_PACKET_LEN + 5;
+    uint8_t frame[protocol::SET_PACKET_LEN + 5];
+    frame[0] = protocol::SYNC;
+    frame[1] = protocol::SYNC;
+    frame[2] = protocol::SET_PACKET_LEN + 2;
+    frame[3] = protocol::CMD_IN_UNIT_REPORT;
+    memcpy(&frame[4], this->last_report_, protocol::SET_PACKET_LEN);
+    finalize_checksum_(frame, frame_len);
+
+    uint8_t one_field[protocol::SET_PACKET_LEN];
+    memcpy(one_field, this->last_report_, sizeof(one_field));
+    one_field[protocol::REPORT_TEMP_ACT_BYTE] ^= 0x01;
+
+    uint8_t all_fields[protocol::SET_PACKET_LEN];
+    memcpy(all_fields, this->last_report_, sizeof(all_fields));
+    for (const auto &entry : ALL_FIELDS_FLIP) {
+        FieldMask_t flip = read_field_mask(&entry);
+        all_fields[flip.byte] ^= flip.mask;
+    }
+    next_option(all_fields, protocol::REPORT_VSWING_BYTE, protocol::REPORT_VSWING_MASK, protocol::REPORT_VSWING_POS,
+                vertical_swing_options::OPTIONS, vertical_swing_options::FROM_WIRE);
+    next_option(all_fields, protocol::REPORT_HSWING_BYTE, protocol::REPORT_HSWING_MASK, protocol::REPORT_HSWING_POS,
+                horizontal_swing_options::OPTIONS, horizontal_swing_options::FROM_WIRE);
+    next_option(all_fields, protocol::REPORT_DISP_MODE_BYTE, protocol::REPORT_DISP_MODE_MASK,
+                protocol::REPORT_DISP_MODE_POS, display_options::OPTIONS, display_options::FROM_WIRE);
+
+    DecodedState_t saved;
+    this->save_decoded_state_(&saved);
+
+    AllocCountFn_t allocs = this->alloc_counter_;
+    BenchStart_t start;
+    volatile uint8_t sink = 0;
+
+    /* framing: a 50 byte report through the synchronizer */
+    SerialProcess_t sp;
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++) {
+        serial_process_reset(&sp);
+        for (size_t j = 0; j < frame_len; j++)
+            serial_process_feed(&sp, frame[j]);
+    }
+    log_result("frame_report", iterations, start, allocs, VERSION);
+
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++)
+        sink = sink + calculate_checksum_(frame, frame_len);
+    log_result("checksum", iterations, start, allocs, VERSION);
+
+    memcpy(this->serialProcess_.data, frame, frame_len);
+    this->serialProcess_.size = frame_len;
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++)
+        sink = sink + verify_packet(verify_checksum_(frame, frame_len));
+    log_result("verify_packet", iterations, start, allocs, VERSION);
+
+    memcpy(this->serialProcess_.data, this->last_report_, protocol::SET_PACKET_LEN);
+    this->serialProcess_.size = protocol::SET_PACKET_LEN;
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++)
+        sink = sink + processUnitReport();
+    log_result("decode_unchanged", iterations, start, allocs, VERSION);
+
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++) {
+        memcpy(this->serialProcess_.data, (i & 1) ? this->last_report_ : one_field, protocol::SET_PACKET_LEN);
+        sink = sink + processUnitReport();
+    }
+    log_result("decode_one_field", iterations, start, allocs, VERSION);
+
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++) {
+        memcpy(this->serialProcess_.data, (i & 1) ? this->last_report_ : all_fields, protocol::SET_PACKET_LEN);
+        sink = sink + processUnitReport();
+    }
+    log_result("decode_all_fields", iterations, start, allocs, VERSION);
+
+    /* encoding works on the state as it was before the run */
+    this->restore_decoded_state_(saved);
+
+    uint8_t packet[protocol::SET_PACKET_LEN + 5];
+    start = bench_start(allocs);
+    for (uint16_t i = 0; i < iterations; i++) {
+        build_params_set_packet_(packet);
+        sink = sink + packet[frame_len - 1];
+    }
+    log_result("encode_params_set", iterations, start, allocs, VERSION);
+
+    (void) sink;
+}
+
+#ifdef GREE_AC_FOOTPRINT_REPORT
+/* read out of the firmware ELF by sniffer/footprint_matrix.py, so the build table has it without a device */
+extern "C" __attribute__((used)) const uint32_t gree_ac_sizeof_cnt = sizeof(GreeACCNT);
+
+/* one JSON line like the benchmarks, footprint_matrix.py --logs picks it up */
+void GreeACCNT::log_footprint()
+{
+    uint32_t heap_free = 0;
+#if defined(USE_ESP8266)
+    heap_free = ESP.getFreeHeap();
+#elif defined(USE_ESP32)
+    heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+#endif
+    ESP_LOGI(TAG, "{\"footprint\":\"idle\",\"sizeof_cnt\":%u,\"heap_free\":%u,\"v\":\"%s\"}",
+             (unsigned) sizeof(GreeACCNT), (unsigned) heap_free, VERSION);
+}
+#endif
+
+}  // namespace CNT
+}  // namespace gree_ac
+}  // namespace esphome
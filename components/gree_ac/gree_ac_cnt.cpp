@@ -1,5 +1,6 @@
 // based on: https://github.com/DomiStyle/esphome-panasonic-ac
 #include "gree_ac_cnt.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 #include "esphome/core/util.h"
 #include <cstring>
@@ -11,20 +12,118 @@ namespace CNT {
 
 static const char *const TAG = "gree_ac.serial";
 
-static const uint8_t ALLOWED_PACKETS[] = {protocol::CMD_IN_UNIT_REPORT, protocol::CMD_IN_MODEL_ID};
+/* high-frequency looping starts this long before a TX slot opens, a bit more than one regular 16 ms loop interval */
+static const uint32_t HIGH_FREQ_TX_LEAD_MS = 20;
+
+/*
+ * Inbound frames the component decodes, everything else is dropped by verify_packet().
+ * To decode another frame type (e.g. CMD_IN_UNKNOWN_2) add a handler and a line here, the loop stays as it is.
+ * min_size is the whole frame from the sync bytes to the checksum.
+ */
+constexpr GreeACCNT::InboundPacket_t GreeACCNT::INBOUND_PACKETS[] = {
+    {protocol::CMD_IN_UNIT_REPORT, protocol::REPORT_TEMP_ACT_BYTE + 6, &GreeACCNT::handle_unit_report_},
+    {protocol::CMD_IN_MODEL_ID,    8,                                  &GreeACCNT::handle_model_id_},
+};
+
+/* command byte -> slot, so checking and dispatching a frame is one array access */
+constexpr GreeACCNT::InboundSlots_t GreeACCNT::build_inbound_slots_()
+{
+    InboundSlots_t slots{};
+    for (size_t i = 0; i < sizeof(INBOUND_PACKETS) / sizeof(INBOUND_PACKETS[0]); i++)
+        slots.slot[INBOUND_PACKETS[i].cmd] = i + 1;
+    return slots;
+}
+constexpr GreeACCNT::InboundSlots_t GreeACCNT::INBOUND_SLOTS PROGMEM = GreeACCNT::build_inbound_slots_();
+
+/* outbound frames which never change, built with their checksum at compile time and kept in flash */
+static constexpr uint8_t STARTUP_PAYLOAD[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x28, 0x1E, 0x19, 0x23, 0x23, 0x00
+};
+static constexpr ConstFrame<sizeof(STARTUP_PAYLOAD)> STARTUP_FRAME PROGMEM{protocol::CMD_OUT_UNKNOWN_1, STARTUP_PAYLOAD};
+static_assert(STARTUP_FRAME.data[sizeof(STARTUP_FRAME.data) - 1] == 0xBA, "startup frame differs from the captured one");
+
+static constexpr uint8_t SYNC_TIME_PAYLOAD[] = {
+    0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7E
+};
+static constexpr ConstFrame<sizeof(SYNC_TIME_PAYLOAD)> SYNC_TIME_FRAME PROGMEM{protocol::CMD_OUT_SYNC_TIME, SYNC_TIME_PAYLOAD};
+
+/* the MAC goes into bytes 4..9 of the payload in setup(), checksum is fixed up there */
+static constexpr uint8_t MAC_REPORT_PAYLOAD[protocol::MAC_REPORT_PAYLOAD_LEN] = {
+    0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+static constexpr ConstFrame<sizeof(MAC_REPORT_PAYLOAD)> MAC_REPORT_FRAME PROGMEM{protocol::CMD_OUT_MAC_REPORT, MAC_REPORT_PAYLOAD};
+static const uint8_t MAC_REPORT_MAC_OFFSET = 8;
+
+/* settings a unit report has to echo before a command counts as confirmed, the fields processUnitReport() decodes */
+static const FieldMask_t CONFIRM_FIELDS[] PROGMEM = {
+    {protocol::REPORT_PWR_BYTE,       protocol::REPORT_PWR_MASK | protocol::REPORT_MODE_MASK | protocol::REPORT_SLEEP_MASK},
+    {protocol::REPORT_TEMP_SET_BYTE,  protocol::REPORT_TEMP_SET_MASK},
+    {protocol::REPORT_DISP_ON_BYTE,   protocol::REPORT_DISP_ON_MASK | protocol::REPORT_IONIZER1_MASK |
+                                      protocol::REPORT_XFAN_MASK | protocol::REPORT_FAN_TURBO_MASK},
+    {protocol::REPORT_DISP_F_BYTE,    protocol::REPORT_DISP_F_MASK},
+    {protocol::REPORT_VSWING_BYTE,    protocol::REPORT_VSWING_MASK | protocol::REPORT_HSWING_MASK},
+    {protocol::REPORT_DISP_MODE_BYTE, protocol::REPORT_DISP_MODE_MASK | protocol::REPORT_IFEEL_MASK},
+    {protocol::REPORT_POWERSAVE_BYTE, protocol::REPORT_POWERSAVE_MASK},
+    {protocol::REPORT_FAN_QUIET_BYTE, protocol::REPORT_FAN_QUIET_MASK | protocol::REPORT_FAN_QUIET_AUTO_MASK},
+    {protocol::REPORT_FAN_SPD1_BYTE,  protocol::REPORT_FAN_SPD1_MASK},
+    {protocol::REPORT_BEEPER_BYTE,    protocol::REPORT_BEEPER_MASK},
+};
+
+/* fields of excluded entities are not decoded, so set frames repeat what the unit reported last
+   instead of overwriting a setting made with the remote. Swing, quiet and turbo are not in here: the climate
+   swing mode and the fan / turbo / quiet interlocks use them, so they are decoded and sent with or without
+   their entities. */
+static const FieldMask_t PASSTHROUGH_FIELDS[] PROGMEM = {
+#ifdef GREE_AC_NO_DISPLAY_SELECT
+    {protocol::REPORT_DISP_MODE_BYTE, protocol::REPORT_DISP_MODE_MASK},
+#endif
+#ifdef GREE_AC_NO_DISPLAY_UNIT_SELECT
+    {protocol::REPORT_DISP_F_BYTE,    protocol::REPORT_DISP_F_MASK},
+#endif
+#ifdef GREE_AC_NO_IONIZER_SWITCH
+    {protocol::REPORT_IONIZER1_BYTE,  protocol::REPORT_IONIZER1_MASK},
+    {protocol::REPORT_IONIZER2_BYTE,  protocol::REPORT_IONIZER2_MASK},
+#endif
+#ifdef GREE_AC_NO_BEEPER_SWITCH
+    {protocol::REPORT_BEEPER_BYTE,    protocol::REPORT_BEEPER_MASK},
+#endif
+#ifdef GREE_AC_NO_SLEEP_SWITCH
+    {protocol::REPORT_SLEEP_BYTE,     protocol::REPORT_SLEEP_MASK},
+#endif
+#ifdef GREE_AC_NO_XFAN_SWITCH
+    {protocol::REPORT_XFAN_BYTE,      protocol::REPORT_XFAN_MASK},
+#endif
+#ifdef GREE_AC_NO_POWERSAVE_SWITCH
+    {protocol::REPORT_POWERSAVE_BYTE, protocol::REPORT_POWERSAVE_MASK},
+#endif
+#ifdef GREE_AC_NO_IFEEL_SWITCH
+    {protocol::REPORT_IFEEL_BYTE,     protocol::REPORT_IFEEL_MASK},
+#endif
+    {0, 0},  /* keeps the table non-empty, a zero mask copies nothing */
+};
 
 void GreeACCNT::setup()
 {
     GreeAC::setup();
     ESP_LOGD(TAG, "Using serial protocol for Gree AC");
 
+    /* the MAC does not change at runtime, so the report is built once and sent as is */
+    progmem_copy(this->mac_report_frame_, MAC_REPORT_FRAME.data, sizeof(this->mac_report_frame_));
+    get_mac_address_raw(&this->mac_report_frame_[MAC_REPORT_MAC_OFFSET]);
+    finalize_checksum_(this->mac_report_frame_, sizeof(this->mac_report_frame_));
+
     this->startup_special_sent_ = false;
     this->mac_packets_pending_ = 3;
     this->last_mac_sequence_millis_ = 0;
-    this->last_sync_time_sent_ = millis() - 10000;
+    this->last_sync_time_sent_ = this->now_() - 10000;
     this->last_packet_duration_ms_ = 0;
     /* allow immediate transmission of the first packet */
-    this->last_packet_sent_ = millis() - protocol::TIME_REFRESH_PERIOD_MS - 1000;
+    this->last_packet_sent_ = this->now_() - protocol::TIME_REFRESH_PERIOD_MS - 1000;
+
+#ifdef GREE_AC_FOOTPRINT_REPORT
+    /* WiFi and the API are up by then, so the free heap is the idle value */
+    this->set_timeout(30000, [this]() { this->log_footprint(); });
+#endif
 }
 
 void GreeACCNT::loop()
@@ -32,7 +131,7 @@ void GreeACCNT::loop()
     /* this reads data from UART */
     GreeAC::loop();
 
-    uint32_t now = millis();
+    uint32_t now = this->now_();
 
     /* we have a frame from AC */
     if (this->serialProcess_.state == STATE_COMPLETE)
@@ -43,8 +142,29 @@ void GreeACCNT::loop()
         /* mark that we have received a response (even if it might be invalid) */
         this->wait_response_ = false;
 
-        if (verify_packet())  /* Verify length, header, counter and checksum */
+        uint32_t phase_start = arch_get_cpu_cycle_count();
+#ifdef GREE_AC_RX_TASK
+        bool checksum_ok = this->rx_checksum_ok_;  /* checked by the RX task already */
+#else
+        bool checksum_ok = this->serialProcess_.size >= 5 && verify_checksum_(this->serialProcess_.data, this->serialProcess_.size);
+#endif
+        bool valid = verify_packet(checksum_ok);  /* Verify length, header, counter and checksum */
+        this->loop_phase_record_(LOOP_PHASE_VERIFY, phase_start);
+        this->trace_(TRACE_VERIFY, valid);
+
+        /* a frame with a good checksum means framing is back, even if the command is one we ignore */
+        if (checksum_ok)
+        {
+            this->note_sync_recovered_(now);
+        }
+        else
+        {
+            this->note_sync_loss_(this->serialProcess_.size, now);
+        }
+
+        if (valid)
         {
+            this->rx_frames_++;
             this->last_packet_received_ = now;  /* Set the time at which we received our last packet */
 
             /* A valid recieved packet of accepted type marks module as being ready */
@@ -54,17 +174,40 @@ void GreeACCNT::loop()
                 Component::status_clear_error();
             }
 
+            uint8_t cmd = this->serialProcess_.data[3];
+            phase_start = arch_get_cpu_cycle_count();
             handle_packet(); /* this will update state of components in HA as well as internal settings */
+            this->loop_phase_record_(LOOP_PHASE_DECODE, phase_start);
+            this->trace_(TRACE_DECODE, cmd);
             yield();
         }
 
+        else
+        {
+            this->rx_errors_++;
+        }
+
         /* restart for next packet */
-        this->serialProcess_.size = 0;
-        this->serialProcess_.state = STATE_WAIT_SYNC;
+        serial_process_reset(&this->serialProcess_);
+    }
+
+    /* heartbeat: republish entities which were not refreshed for too long */
+    if (this->state_ == ACState::Ready)
+    {
+        this->mark_stale_entities_(now);
+    }
+
+    /* every publish fans out into API messages, so only a few entities go out per loop */
+    if (this->publish_pending_ != 0)
+    {
+        uint32_t phase_start = arch_get_cpu_cycle_count();
+        this->publish_pending_entities_();
+        this->loop_phase_record_(LOOP_PHASE_PUBLISH, phase_start);
     }
 
     /* we will send a packet to the AC as a response to indicate changes */
-    /* Check for 330ms gap since last packet finished transmission */
+    /* Check for 330ms gap since last packet finished transmission; not subject to the loop budget,
+       the unit expects its answer in time */
     if (now - this->last_packet_sent_ >= (protocol::TIME_REFRESH_PERIOD_MS + this->last_packet_duration_ms_))
     {
         if (!this->startup_special_sent_)
@@ -96,7 +239,7 @@ void GreeACCNT::loop()
     }
 
     /* if there are no packets for some time - mark module as not ready */
-    if (millis() - this->last_packet_received_ >= protocol::TIME_TIMEOUT_INACTIVE_MS)
+    if (this->now_() - this->last_packet_received_ >= protocol::TIME_TIMEOUT_INACTIVE_MS)
     {
         if (this->state_ != ACState::Initializing)
         {
@@ -104,6 +247,33 @@ void GreeACCNT::loop()
             Component::status_set_error();
         }
     }
+
+    /* packet dumps are the least important work of the loop */
+    if (!this->loop_budget_exceeded_())
+    {
+        this->flush_packet_log_();
+    }
+
+    /* loop at full speed only while a frame is coming in or the next TX slot is about to open */
+    if (this->rx_in_flight_() || this->tx_due_soon_(this->now_()))
+    {
+        this->high_freq_.start();
+    }
+    else
+    {
+        this->high_freq_.stop();
+    }
+
+    this->loop_phase_record_(LOOP_PHASE_TOTAL, this->loop_start_cycles_);
+    this->publish_loop_stats_();
+}
+
+/* true during the last HIGH_FREQ_TX_LEAD_MS before the next frame may be sent, false once the slot is open */
+bool GreeACCNT::tx_due_soon_(uint32_t now)
+{
+    uint32_t elapsed = now - this->last_packet_sent_;
+    uint32_t period = protocol::TIME_REFRESH_PERIOD_MS + this->last_packet_duration_ms_;
+    return elapsed < period && period - elapsed <= HIGH_FREQ_TX_LEAD_MS;
 }
 
 /*
@@ -113,10 +283,43 @@ void GreeACCNT::loop()
 void GreeACCNT::mark_for_update_() {
     this->reqmodechange = true;
     this->update_ = ACUpdate::UpdateStart;
+
+    /* several changes before the next update frame are one command, timed from the first of them;
+       a change after the frame was sent supersedes the command still waiting for confirmation */
+    if (this->confirm_ != ACConfirm::Queued) {
+        this->confirm_ = ACConfirm::Queued;
+        this->confirm_start_ = this->now_();
+    }
+}
+
+/* called with the payload of every unit report which is decoded, see handle_unit_report_() */
+void GreeACCNT::check_confirmation_()
+{
+    if (this->confirm_ != ACConfirm::Sent)
+        return;
+
+    uint32_t elapsed = this->now_() - this->confirm_start_;
+    for (const auto &entry : CONFIRM_FIELDS) {
+        FieldMask_t field = read_field_mask(&entry);
+        if ((this->serialProcess_.data[field.byte] ^ this->confirm_expected_[field.byte]) & field.mask) {
+            if (elapsed >= protocol::TIME_CONFIRM_TIMEOUT_MS) {
+                this->confirm_timeouts_++;
+                this->confirm_ = ACConfirm::Idle;
+                ESP_LOGW(TAG, "Command not confirmed by the unit within %u ms (byte %u differs), %u so far",
+                         (unsigned) elapsed, field.byte, (unsigned) this->confirm_timeouts_);
+            }
+            return;
+        }
+    }
+
+    this->confirm_ = ACConfirm::Idle;
+    this->note_command_confirmed_(elapsed);
 }
 
 void GreeACCNT::control(const climate::ClimateCall &call)
 {
+    this->trace_(TRACE_CONTROL, 0);
+
     if (this->state_ != ACState::Ready)
         return;
 
@@ -207,26 +410,117 @@ void GreeACCNT::control(const climate::ClimateCall &call)
     }
 }
 
+/* option index of a scene value; values from a lambda are not validated by the config, unknown ones are skipped */
+template<size_t N> static uint8_t scene_option(const OptionDef (&options)[N], const optional<std::string> &value, const char *field)
+{
+    if (!value.has_value())
+        return OPTION_NONE;
+
+    uint8_t index = option_index(options, value->c_str());
+    if (index == OPTION_NONE)
+        ESP_LOGW(TAG, "Ignoring unknown %s '%s' in scene", field, value->c_str());
+    return index;
+}
+
+void GreeACCNT::apply_scene(const SceneParams &scene)
+{
+    this->trace_(TRACE_CONTROL, 1);
+
+    if (this->state_ != ACState::Ready)
+    {
+        ESP_LOGW(TAG, "Ignoring scene, AC unit is not ready");
+        return;
+    }
+
+    ESP_LOGD(TAG, "Applying scene");
+
+    if (scene.mode.has_value())
+    {
+        this->mode = *scene.mode;
+        if (this->light_mode_ == light_options::AUTO)
+        {
+            this->light_state_ = (this->mode != climate::CLIMATE_MODE_OFF);
+        }
+    }
+
+    if (scene.target_temperature.has_value())
+    {
+        this->target_temperature = clamp<float>(*scene.target_temperature, MIN_TEMPERATURE, MAX_TEMPERATURE);
+    }
+
+    uint8_t fan_mode = scene_option(fan_modes::OPTIONS, scene.fan_mode, "fan mode");
+    if (fan_mode != OPTION_NONE)
+    {
+        this->update_fan_mode(fan_mode);
+    }
+
+    uint8_t vertical_swing = scene_option(vertical_swing_options::OPTIONS, scene.vertical_swing, "vertical swing");
+    if (vertical_swing != OPTION_NONE)
+    {
+        this->update_swing_vertical(vertical_swing);
+    }
+
+    uint8_t horizontal_swing = scene_option(horizontal_swing_options::OPTIONS, scene.horizontal_swing, "horizontal swing");
+    if (horizontal_swing != OPTION_NONE)
+    {
+        this->update_swing_horizontal(horizontal_swing);
+    }
+
+    /* Resolve the turbo/quiet interlocks once for the whole scene instead of per callback:
+       a fan change clears both (Requirement 3) unless the scene sets them, and turbo excludes quiet (Requirement 1).
+       If the scene asks for both, turbo wins. */
+    uint8_t quiet_requested = scene_option(quiet_options::OPTIONS, scene.quiet, "quiet mode");
+    bool turbo = scene.turbo.value_or(fan_mode != OPTION_NONE ? false : this->turbo_state_);
+    uint8_t quiet = quiet_requested;
+    if (quiet == OPTION_NONE)
+    {
+        quiet = (fan_mode != OPTION_NONE) ? (uint8_t) quiet_options::OFF : this->quiet_state_;
+    }
+    if (turbo && quiet != quiet_options::OFF)
+    {
+        if (scene.turbo.has_value() && quiet_requested != OPTION_NONE)
+        {
+            ESP_LOGW(TAG, "Scene requests both turbo and quiet, turbo takes precedence");
+            quiet = quiet_options::OFF;
+        }
+        else if (quiet_requested != OPTION_NONE)
+        {
+            turbo = false;
+        }
+        else
+        {
+            quiet = quiet_options::OFF;
+        }
+    }
+    this->update_turbo(turbo);
+    this->update_quiet(quiet);
+
+    /* one 0xAF frame carries the whole scene */
+    this->mark_for_update_();
+}
+
+/* with rx_task the RX task reads the same UART meanwhile, see GreeAC::rx_task_() for why that is safe */
 void GreeACCNT::transmit_packet(const uint8_t *packet, size_t length)
 {
-    this->last_packet_sent_ = millis();
+    uint32_t phase_start = arch_get_cpu_cycle_count();
+    this->last_packet_sent_ = this->now_();
     this->last_packet_duration_ms_ = (length * 11000) / 4800;
 
     log_packet(packet, length, true);
 
-    if (this->enable_tx_switch_ == nullptr || this->enable_tx_switch_->state) {
+    if (this->tx_enabled_()) {
         write_array(packet, length);
+        this->tx_frames_++;
+        this->trace_(TRACE_TX, length > 3 ? packet[3] : 0);
     }
+    this->loop_phase_record_(LOOP_PHASE_TX, phase_start);
     yield();
 }
 
 void GreeACCNT::send_special_startup_packet()
 {
-    uint8_t packet[] = {
-        0x7E, 0x7E, 0x10, 0x02,
-        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00,
-        0x28, 0x1E, 0x19, 0x23, 0x23, 0x00, 0xBA
-    };
+    uint8_t packet[sizeof(STARTUP_FRAME.data)];
+    progmem_copy(packet, STARTUP_FRAME.data, sizeof(packet));
     transmit_packet(packet, sizeof(packet));
     this->startup_special_sent_ = true;
     ESP_LOGD(TAG, "Sent special startup packet");
@@ -239,7 +533,7 @@ void GreeACCNT::send_params_set_packet()
 {
     if (this->wait_response_)
     {
-        if (millis() - this->last_packet_sent_ < protocol::TIME_WAIT_RESPONSE_TIMEOUT_MS)
+        if (this->now_() - this->last_packet_sent_ < protocol::TIME_WAIT_RESPONSE_TIMEOUT_MS)
         {
             /* waiting for report to come */
             return;
@@ -251,6 +545,41 @@ void GreeACCNT::send_params_set_packet()
         }
     }
 
+    uint32_t phase_start = arch_get_cpu_cycle_count();
+    uint8_t full_packet[protocol::SET_PACKET_LEN + 5];
+    this->build_params_set_packet_(full_packet);
+    this->loop_phase_record_(LOOP_PHASE_ENCODE, phase_start);
+    if (this->update_ == ACUpdate::UpdateStart) {
+        this->trace_(TRACE_AF_BUILD);
+        if (this->confirm_ == ACConfirm::Queued) {
+            memcpy(this->confirm_expected_, &full_packet[4], protocol::SET_PACKET_LEN);
+            this->confirm_ = ACConfirm::Sent;
+        }
+    }
+
+    this->wait_response_ = true;
+    transmit_packet(full_packet, sizeof(full_packet));
+
+    /* update setting state-machine */
+    switch(this->update_)
+    {
+        case ACUpdate::NoUpdate:
+            break;
+        case ACUpdate::UpdateStart:
+            this->update_ = ACUpdate::NoUpdate; // Transition directly to NoUpdate to send AF only once
+            break;
+        case ACUpdate::UpdateClear:
+            this->update_ = ACUpdate::NoUpdate;
+            break;
+        default:
+            this->update_ = ACUpdate::NoUpdate;
+            break;
+    }
+}
+
+/* encodes the current settings into a complete CMD_OUT_PARAMS_SET frame of SET_PACKET_LEN + 5 bytes */
+void GreeACCNT::build_params_set_packet_(uint8_t *full_packet)
+{
     uint8_t payload[protocol::SET_PACKET_LEN];
     memset(payload, 0, sizeof(payload));
     
@@ -335,43 +664,9 @@ void GreeACCNT::send_params_set_packet()
     payload[protocol::REPORT_TEMP_SET_BYTE] |= ((target_temperature - protocol::REPORT_TEMP_SET_OFF) << protocol::REPORT_TEMP_SET_POS) & protocol::REPORT_TEMP_SET_MASK;
 
     // FAN STATE
-    uint8_t fan_mode_payload4 = 0x00;
-    uint8_t fan_mode_payload18 = 0x00;
-
-    if (this->fan_mode.has_value()) {
-        switch (*this->fan_mode) {
-            case climate::CLIMATE_FAN_AUTO:
-                fan_mode_payload4 = 0x00;
-                fan_mode_payload18 = 0x00;
-                break;
-            case climate::CLIMATE_FAN_LOW:
-                fan_mode_payload4 = 0x02;
-                fan_mode_payload18 = 0x02;
-                break;
-            case climate::CLIMATE_FAN_MEDIUM:
-                fan_mode_payload4 = 0x02;
-                fan_mode_payload18 = 0x03;
-                break;
-            case climate::CLIMATE_FAN_HIGH:
-                fan_mode_payload4 = 0x03;
-                fan_mode_payload18 = 0x04;
-                break;
-            default:
-                break;
-        }
-    }
-
-    if (this->has_custom_fan_mode()) {
-        const auto custom_fan_mode = this->get_custom_fan_mode();
-
-        if (custom_fan_mode == fan_modes::FAN_MIN) {
-            fan_mode_payload4 = 0x01;
-            fan_mode_payload18 = 0x01;
-        } else if (custom_fan_mode == fan_modes::FAN_MAX) {
-            fan_mode_payload4 = 0x03;
-            fan_mode_payload18 = 0x05;
-        }
-    }
+    uint8_t fan_mode = this->fan_mode_index_();
+    uint8_t fan_mode_payload4 = progmem_read_byte(&fan_modes::SPD2[fan_mode]);
+    uint8_t fan_mode_payload18 = option_wire(fan_modes::OPTIONS, fan_mode, 0);
 
     payload[protocol::REPORT_FAN_SPD1_BYTE] = 0;
     payload[protocol::REPORT_FAN_SPD1_BYTE] |= (fan_mode_payload18 & protocol::REPORT_FAN_SPD1_MASK);
@@ -387,73 +682,21 @@ void GreeACCNT::send_params_set_packet()
     }
 
     // QUIET STATE
-    if (this->quiet_state_ == quiet_options::ON)
-    {
-        payload[protocol::REPORT_FAN_QUIET_BYTE] |= protocol::REPORT_FAN_QUIET_MASK;
-    }
-    else if (this->quiet_state_ == quiet_options::AUTO)
-    {
-        payload[protocol::REPORT_FAN_QUIET_BYTE] |= protocol::REPORT_FAN_QUIET_AUTO_MASK;
-    }
+    payload[protocol::REPORT_FAN_QUIET_BYTE] |= option_wire(quiet_options::OPTIONS, this->quiet_state_, 0);
 
     // VERTICAL SWING
-    static const struct { const char* const opt; uint8_t val; } VSWING_MAP[] = {
-        {vertical_swing_options::OFF,   protocol::REPORT_VSWING_OFF},
-        {vertical_swing_options::FULL,  protocol::REPORT_VSWING_FULL},
-        {vertical_swing_options::DOWN,  protocol::REPORT_VSWING_DOWN},
-        {vertical_swing_options::MIDD,  protocol::REPORT_VSWING_MIDD},
-        {vertical_swing_options::MID,   protocol::REPORT_VSWING_MID},
-        {vertical_swing_options::MIDU,  protocol::REPORT_VSWING_MIDU},
-        {vertical_swing_options::UP,    protocol::REPORT_VSWING_UP},
-        {vertical_swing_options::CDOWN, protocol::REPORT_VSWING_CDOWN},
-        {vertical_swing_options::CMIDD, protocol::REPORT_VSWING_CMIDD},
-        {vertical_swing_options::CMID,  protocol::REPORT_VSWING_CMID},
-        {vertical_swing_options::CMIDU, protocol::REPORT_VSWING_CMIDU},
-        {vertical_swing_options::CUP,   protocol::REPORT_VSWING_CUP},
-    };
-
-    uint8_t mode_vertical_swing = protocol::REPORT_VSWING_OFF;
-    for (const auto& mapping : VSWING_MAP) {
-        if (this->vertical_swing_state_ == mapping.opt) {
-            mode_vertical_swing = mapping.val;
-            break;
-        }
-    }
-
+    uint8_t mode_vertical_swing = option_wire(vertical_swing_options::OPTIONS, this->vertical_swing_state_, protocol::REPORT_VSWING_OFF);
     payload[protocol::REPORT_VSWING_BYTE] |= (mode_vertical_swing << protocol::REPORT_VSWING_POS);
 
     // HORIZONTAL SWING
-    static const struct { const char* const opt; uint8_t val; } HSWING_MAP[] = {
-        {horizontal_swing_options::OFF,    protocol::REPORT_HSWING_OFF},
-        {horizontal_swing_options::FULL,   protocol::REPORT_HSWING_FULL},
-        {horizontal_swing_options::CLEFT,  protocol::REPORT_HSWING_CLEFT},
-        {horizontal_swing_options::CMIDL,  protocol::REPORT_HSWING_CMIDL},
-        {horizontal_swing_options::CMID,   protocol::REPORT_HSWING_CMID},
-        {horizontal_swing_options::CMIDR,  protocol::REPORT_HSWING_CMIDR},
-        {horizontal_swing_options::CRIGHT, protocol::REPORT_HSWING_CRIGHT},
-    };
-
-    uint8_t mode_horizontal_swing = protocol::REPORT_HSWING_OFF;
-    for (const auto& mapping : HSWING_MAP) {
-        if (this->horizontal_swing_state_ == mapping.opt) {
-            mode_horizontal_swing = mapping.val;
-            break;
-        }
-    }
+    uint8_t mode_horizontal_swing = option_wire(horizontal_swing_options::OPTIONS, this->horizontal_swing_state_, protocol::REPORT_HSWING_OFF);
     payload[protocol::REPORT_HSWING_BYTE] |= (mode_horizontal_swing << protocol::REPORT_HSWING_POS);
 
     /* DISPLAY --------------------------------------------------------------------------- */
     uint8_t display_mode = protocol::REPORT_DISP_MODE_SET;
     if (this->mode != climate::CLIMATE_MODE_OFF)
     {
-        if (this->display_state_ == display_options::SET)
-        {
-            display_mode = protocol::REPORT_DISP_MODE_SET;
-        }
-        else if (this->display_state_ == display_options::ACT)
-        {
-            display_mode = protocol::REPORT_DISP_MODE_ACT;
-        }
+        display_mode = option_wire(display_options::OPTIONS, this->display_state_, protocol::REPORT_DISP_MODE_SET);
     }
     else
     {
@@ -511,76 +754,38 @@ void GreeACCNT::send_params_set_packet()
         payload[protocol::REPORT_IFEEL_BYTE] |= protocol::REPORT_IFEEL_MASK;
     }
 
+    /* EXCLUDED ENTITIES --------------------------------------------------------------------------- */
+    for (const auto &entry : PASSTHROUGH_FIELDS)
+    {
+        FieldMask_t field = read_field_mask(&entry);
+        payload[field.byte] = (payload[field.byte] & ~field.mask) | (this->last_report_[field.byte] & field.mask);
+    }
+
     /* Do the command, length */
 
-    uint8_t full_packet[protocol::SET_PACKET_LEN + 5];
     full_packet[0] = protocol::SYNC;
     full_packet[1] = protocol::SYNC;
     full_packet[2] = protocol::SET_PACKET_LEN + 2;
     full_packet[3] = protocol::CMD_OUT_PARAMS_SET;
     memcpy(&full_packet[4], payload, protocol::SET_PACKET_LEN);
 
-    finalize_checksum_(full_packet, sizeof(full_packet));
-
-    this->wait_response_ = true;
-    transmit_packet(full_packet, sizeof(full_packet));
-
-    /* update setting state-machine */
-    switch(this->update_)
-    {
-        case ACUpdate::NoUpdate:
-            break;
-        case ACUpdate::UpdateStart:
-            this->update_ = ACUpdate::NoUpdate; // Transition directly to NoUpdate to send AF only once
-            break;
-        case ACUpdate::UpdateClear:
-            this->update_ = ACUpdate::NoUpdate;
-            break;
-        default:
-            this->update_ = ACUpdate::NoUpdate;
-            break;
-    }
+    finalize_checksum_(full_packet, protocol::SET_PACKET_LEN + 5);
 }
 
 void GreeACCNT::send_mac_report_packet()
 {
-    uint8_t full_packet[16];
-    uint8_t mac[6];
-    get_mac_address_raw(mac);
-
-    full_packet[0] = protocol::SYNC;
-    full_packet[1] = protocol::SYNC;
-    full_packet[2] = 0x0D; // Length
-    full_packet[3] = protocol::CMD_OUT_MAC_REPORT;
-    full_packet[4] = 0x07;
-    full_packet[5] = 0x00;
-    full_packet[6] = 0x00;
-    full_packet[7] = 0x00;
-    memcpy(&full_packet[8], mac, 6);
-    full_packet[14] = 0x00;
-
-    finalize_checksum_(full_packet, sizeof(full_packet));
-
+    const uint8_t *mac = &this->mac_report_frame_[MAC_REPORT_MAC_OFFSET];
     ESP_LOGD(TAG, "Sending MAC report: %02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    transmit_packet(full_packet, 16);
+    transmit_packet(this->mac_report_frame_, sizeof(this->mac_report_frame_));
 }
 
 void GreeACCNT::send_sync_time_packet()
 {
-    uint8_t full_packet[17];
-    full_packet[0] = protocol::SYNC;
-    full_packet[1] = protocol::SYNC;
-    full_packet[2] = 0x0E; // Length
-    full_packet[3] = protocol::CMD_OUT_SYNC_TIME;
-    full_packet[4] = 0x04;
-    memset(&full_packet[5], 0, 10);
-    full_packet[15] = 0x7E;
-
-    finalize_checksum_(full_packet, sizeof(full_packet));
-
     ESP_LOGD(TAG, "Sending sync time packet");
-    transmit_packet(full_packet, 17);
-    this->last_sync_time_sent_ = millis();
+    uint8_t packet[sizeof(SYNC_TIME_FRAME.data)];
+    progmem_copy(packet, SYNC_TIME_FRAME.data, sizeof(packet));
+    transmit_packet(packet, sizeof(packet));
+    this->last_sync_time_sent_ = this->now_();
 }
 
 /*
@@ -588,11 +793,7 @@ void GreeACCNT::send_sync_time_packet()
  */
 
 uint8_t GreeACCNT::calculate_checksum_(const uint8_t *data, size_t len) {
-    uint8_t checksum = 0;
-    for (size_t i = 2; i < len - 1; i++) {
-        checksum += data[i];
-    }
-    return checksum;
+    return frame_checksum(data, len);
 }
 
 void GreeACCNT::finalize_checksum_(uint8_t *data, size_t len) {
@@ -603,7 +804,7 @@ bool GreeACCNT::verify_checksum_(const uint8_t *data, size_t len) {
     return data[len - 1] == calculate_checksum_(data, len);
 }
 
-bool GreeACCNT::verify_packet()
+bool GreeACCNT::verify_packet(bool checksum_ok)
 {
     /* At least 2 sync bytes + length + type + checksum */
     if (this->serialProcess_.size < 5)
@@ -617,22 +818,19 @@ bool GreeACCNT::verify_packet()
     /* The frame len was assumed by GreeAC::loop() */
 
     /* Check if this packet type sould be processed */
-    bool commandAllowed = false;
-    for (uint8_t packet : ALLOWED_PACKETS)
+    uint8_t slot = progmem_read_byte(&INBOUND_SLOTS.slot[this->serialProcess_.data[3]]);
+    if (slot == 0)
     {
-        if (this->serialProcess_.data[3] == packet)
-        {
-            commandAllowed = true;
-            break;
-        }
+        ESP_LOGW(TAG, "Dropping invalid packet (command [%02X] not allowed)", this->serialProcess_.data[3]);
+        return false;
     }
-    if (!commandAllowed)
+    if (this->serialProcess_.size < INBOUND_PACKETS[slot - 1].min_size)
     {
-        ESP_LOGW(TAG, "Dropping invalid packet (command [%02X] not allowed)", this->serialProcess_.data[3]);
+        ESP_LOGW(TAG, "Dropping invalid packet (command [%02X] too short)", this->serialProcess_.data[3]);
         return false;
     }
 
-    if (!verify_checksum_(this->serialProcess_.data, this->serialProcess_.size))
+    if (!checksum_ok)
     {
         ESP_LOGD(TAG, "Dropping invalid packet (checksum)");
         return false;
@@ -643,51 +841,57 @@ bool GreeACCNT::verify_packet()
 
 void GreeACCNT::handle_packet()
 {
-    if (this->serialProcess_.data[3] == protocol::CMD_IN_UNIT_REPORT)
-    {
-        if (this->update_ != ACUpdate::NoUpdate) {
-            return;
-        }
+    /* verify_packet() only lets commands with a slot through */
+    const InboundPacket_t &packet = INBOUND_PACKETS[progmem_read_byte(&INBOUND_SLOTS.slot[this->serialProcess_.data[3]]) - 1];
+    (this->*packet.handler)();
+}
 
-        /* Move payload to front of data array to simplify indexing (remove 4 byte header) */
-        size_t payload_size = this->serialProcess_.size - 5;
-        memmove(this->serialProcess_.data, &this->serialProcess_.data[4], payload_size);
-        this->serialProcess_.size = payload_size;
+void GreeACCNT::handle_unit_report_()
+{
+    if (this->update_ != ACUpdate::NoUpdate) {
+        return;
+    }
 
-        /* now process the data */
-        bool hasChanged = this->processUnitReport();
+    /* Move payload to front of data array to simplify indexing (remove 4 byte header) */
+    size_t payload_size = this->serialProcess_.size - 5;
+    memmove(this->serialProcess_.data, &this->serialProcess_.data[4], payload_size);
+    this->serialProcess_.size = payload_size;
 
-        if (hasChanged || reqmodechange)
-        {
-            ESP_LOGD(TAG, "State update: hasChanged=%d, reqmodechange=%d", hasChanged, reqmodechange);
-            this->publish_state();
-            reqmodechange = false;
-        }
+    if (payload_size == protocol::SET_PACKET_LEN) {
+        memcpy(this->last_report_, this->serialProcess_.data, payload_size);
+        this->has_last_report_ = true;
+        this->check_confirmation_();
     }
-    else if (this->serialProcess_.data[3] == protocol::CMD_IN_MODEL_ID)
+
+    /* now process the data */
+    bool hasChanged = this->processUnitReport();
+
+    if (hasChanged || reqmodechange)
     {
-        if (this->serialProcess_.size < 7) {
-            ESP_LOGW(TAG, "Model ID packet too short");
-            return;
-        }
-        uint8_t b1 = this->serialProcess_.data[4];
-        uint8_t b2 = this->serialProcess_.data[5];
-        uint8_t b3 = this->serialProcess_.data[6];
+        ESP_LOGD(TAG, "State update: hasChanged=%d, reqmodechange=%d", hasChanged, reqmodechange);
+        this->mark_for_publish_(PUBLISH_CLIMATE);
+        this->mark_for_publish_(PUBLISH_SNAPSHOT);
+        reqmodechange = false;
+    }
+}
 
-        char buf[32];
-        snprintf(buf, sizeof(buf), "%d%02d%02d", b1, b2, b3);
-        std::string model_id = buf;
+void GreeACCNT::handle_model_id_()
+{
+    uint8_t b1 = this->serialProcess_.data[4];
+    uint8_t b2 = this->serialProcess_.data[5];
+    uint8_t b3 = this->serialProcess_.data[6];
 
-        ESP_LOGI(TAG, "Received Model ID: %s", model_id.c_str());
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d%02d%02d", b1, b2, b3);
+    std::string model_id = buf;
 
-        if (this->model_id_text_sensor_ != nullptr && this->model_id_text_sensor_->state != model_id) {
-            this->model_id_text_sensor_->publish_state(model_id);
-        }
-    }
-    else
-    {
-        ESP_LOGD(TAG, "Received unknown packet type: 0x%02X", this->serialProcess_.data[3]);
+    ESP_LOGI(TAG, "Received Model ID: %s", model_id.c_str());
+
+#ifndef GREE_AC_NO_MODEL_ID_TEXT_SENSOR
+    if (this->model_id_text_sensor_ != nullptr && this->model_id_text_sensor_->state != model_id) {
+        this->model_id_text_sensor_->publish_state(model_id);
     }
+#endif
 }
 
 /*
@@ -718,18 +922,18 @@ bool GreeACCNT::processUnitReport()
     hasChanged |= this->update_target_temperature((float)(temset + protocol::REPORT_TEMP_SET_OFF));
     hasChanged |= this->update_current_temperature((float)(this->serialProcess_.data[protocol::REPORT_TEMP_ACT_BYTE] - protocol::REPORT_TEMP_ACT_OFF));
 
-    const char* verticalSwing = determine_vertical_swing();
-    hasChanged |= this->update_swing_vertical(verticalSwing);
-
-    const char* horizontalSwing = determine_horizontal_swing();
-    hasChanged |= this->update_swing_horizontal(horizontalSwing);
+    /* swing is decoded even without the selects, the climate swing mode is made from it */
+    hasChanged |= this->update_swing_vertical(determine_vertical_swing());
+    hasChanged |= this->update_swing_horizontal(determine_horizontal_swing());
 
     climate::ClimateSwingMode newSwingMode;
-    if (strcmp(verticalSwing, vertical_swing_options::FULL) == 0 && strcmp(horizontalSwing, horizontal_swing_options::FULL) == 0)
+    bool verticalFull = this->vertical_swing_state_ == vertical_swing_options::FULL;
+    bool horizontalFull = this->horizontal_swing_state_ == horizontal_swing_options::FULL;
+    if (verticalFull && horizontalFull)
         newSwingMode = climate::CLIMATE_SWING_BOTH;
-    else if (strcmp(verticalSwing, vertical_swing_options::FULL) == 0)
+    else if (verticalFull)
         newSwingMode = climate::CLIMATE_SWING_VERTICAL;
-    else if (strcmp(horizontalSwing, horizontal_swing_options::FULL) == 0)
+    else if (horizontalFull)
         newSwingMode = climate::CLIMATE_SWING_HORIZONTAL;
     else
         newSwingMode = climate::CLIMATE_SWING_OFF;
@@ -739,7 +943,8 @@ bool GreeACCNT::processUnitReport()
         hasChanged = true;
     }
 
-    const char* display = determine_display();
+#ifndef GREE_AC_NO_DISPLAY_SELECT
+    uint8_t display = determine_display();
     if (this->mode != climate::CLIMATE_MODE_OFF) {
         if (modeChanged && this->display_state_ == display_options::ACT) {
             // Unit just turned ON and we want Actual temperature.
@@ -750,13 +955,19 @@ bool GreeACCNT::processUnitReport()
     } else {
         // When OFF, AC unit always reports "Set temperature".
         // We only follow it if it's "Actual" (unlikely when OFF) or if we don't have a state yet.
-        if (this->display_state_.empty() || strcmp(display, display_options::ACT) == 0) {
+        if (this->display_state_ == OPTION_NONE || display == display_options::ACT) {
             hasChanged |= this->update_display(display);
         }
     }
+#endif
 
+    /* the light policy runs without the select as well, it just stays at Auto */
     bool light_reported = determine_light();
-    if (this->light_state_ != light_reported || (this->light_select_ != nullptr && this->light_select_->current_option().empty())) {
+    bool light_unpublished = false;
+#ifndef GREE_AC_NO_LIGHT_SELECT
+    light_unpublished = this->light_select_ != nullptr && !this->light_select_->active_index().has_value();
+#endif
+    if (this->light_state_ != light_reported || light_unpublished) {
         if (this->light_mode_ == light_options::AUTO)
         {
             if (!modeChanged) {
@@ -790,14 +1001,29 @@ bool GreeACCNT::processUnitReport()
         }
     }
 
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
     hasChanged |= this->update_display_unit(determine_display_unit());
+#endif
+#ifndef GREE_AC_NO_IONIZER_SWITCH
     hasChanged |= this->update_ionizer(determine_ionizer());
+#endif
+#ifndef GREE_AC_NO_BEEPER_SWITCH
     hasChanged |= this->update_beeper(determine_beeper());
+#endif
+#ifndef GREE_AC_NO_SLEEP_SWITCH
     hasChanged |= this->update_sleep(determine_sleep());
+#endif
+#ifndef GREE_AC_NO_XFAN_SWITCH
     hasChanged |= this->update_xfan(determine_xfan());
+#endif
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
     hasChanged |= this->update_powersave(determine_powersave());
+#endif
+    /* turbo and quiet as well, for the fan / turbo / quiet interlocks */
     hasChanged |= this->update_turbo(determine_turbo());
+#ifndef GREE_AC_NO_IFEEL_SWITCH
     hasChanged |= this->update_ifeel(determine_ifeel());
+#endif
     hasChanged |= this->update_quiet(determine_quiet());
     hasChanged |= this->update_fan_mode(determine_fan_mode());
 
@@ -848,95 +1074,57 @@ climate::ClimateMode GreeACCNT::determine_mode()
     }
 }
 
-const char* GreeACCNT::determine_fan_mode()
+uint8_t GreeACCNT::determine_fan_mode()
 {
     /* fan setting has quite complex representation in the packet, brace for it */
     uint8_t fan_mode = (this->serialProcess_.data[protocol::REPORT_FAN_SPD1_BYTE] & protocol::REPORT_FAN_SPD1_MASK);
 
-    switch (fan_mode) {
-        case 0x01:
-            return fan_modes::FAN_MIN;
-        case 0x02:
-            return fan_modes::FAN_LOW;
-        case 0x03:
-            return fan_modes::FAN_MED;
-        case 0x04:
-            return fan_modes::FAN_HIGH;
-        case 0x05:
-            return fan_modes::FAN_MAX;
-        case 0x00:
-            return fan_modes::FAN_AUTO;
-        default:
-            ESP_LOGW(TAG, "Received unknown fan mode: %d", fan_mode);
-            return fan_modes::FAN_AUTO;
+    uint8_t index = fan_modes::FROM_WIRE[fan_mode];
+    if (index == OPTION_NONE) {
+        ESP_LOGW(TAG, "Received unknown fan mode: %d", fan_mode);
+        return fan_modes::FAN_AUTO;
     }
+    return index;
 }
 
-const char* GreeACCNT::determine_vertical_swing()
+uint8_t GreeACCNT::determine_vertical_swing()
 {
     uint8_t mode = (this->serialProcess_.data[protocol::REPORT_VSWING_BYTE]  & protocol::REPORT_VSWING_MASK) >> protocol::REPORT_VSWING_POS;
 
-    static const struct { uint8_t val; const char* const opt; } VSWING_MAP[] = {
-        {protocol::REPORT_VSWING_OFF,   vertical_swing_options::OFF},
-        {protocol::REPORT_VSWING_FULL,  vertical_swing_options::FULL},
-        {protocol::REPORT_VSWING_CUP,   vertical_swing_options::CUP},
-        {protocol::REPORT_VSWING_CMIDU, vertical_swing_options::CMIDU},
-        {protocol::REPORT_VSWING_CMID,  vertical_swing_options::CMID},
-        {protocol::REPORT_VSWING_CMIDD, vertical_swing_options::CMIDD},
-        {protocol::REPORT_VSWING_CDOWN, vertical_swing_options::CDOWN},
-        {protocol::REPORT_VSWING_DOWN,  vertical_swing_options::DOWN},
-        {protocol::REPORT_VSWING_MIDD,  vertical_swing_options::MIDD},
-        {protocol::REPORT_VSWING_MID,   vertical_swing_options::MID},
-        {protocol::REPORT_VSWING_MIDU,  vertical_swing_options::MIDU},
-        {protocol::REPORT_VSWING_UP,    vertical_swing_options::UP},
-    };
-
-    for (const auto& mapping : VSWING_MAP) {
-        if (mode == mapping.val) return mapping.opt;
-    }
-
-    ESP_LOGW(TAG, "Received unknown vertical swing mode");
-    return vertical_swing_options::OFF;
+    uint8_t index = vertical_swing_options::FROM_WIRE[mode];
+    if (index == OPTION_NONE) {
+        ESP_LOGW(TAG, "Received unknown vertical swing mode");
+        return vertical_swing_options::OFF;
+    }
+    return index;
 }
 
-const char* GreeACCNT::determine_horizontal_swing()
+uint8_t GreeACCNT::determine_horizontal_swing()
 {
     uint8_t mode = (this->serialProcess_.data[protocol::REPORT_HSWING_BYTE]  & protocol::REPORT_HSWING_MASK) >> protocol::REPORT_HSWING_POS;
 
-    static const struct { uint8_t val; const char* const opt; } HSWING_MAP[] = {
-        {protocol::REPORT_HSWING_OFF,    horizontal_swing_options::OFF},
-        {protocol::REPORT_HSWING_FULL,   horizontal_swing_options::FULL},
-        {protocol::REPORT_HSWING_CLEFT,  horizontal_swing_options::CLEFT},
-        {protocol::REPORT_HSWING_CMIDL,  horizontal_swing_options::CMIDL},
-        {protocol::REPORT_HSWING_CMID,   horizontal_swing_options::CMID},
-        {protocol::REPORT_HSWING_CMIDR,  horizontal_swing_options::CMIDR},
-        {protocol::REPORT_HSWING_CRIGHT, horizontal_swing_options::CRIGHT},
-    };
-
-    for (const auto& mapping : HSWING_MAP) {
-        if (mode == mapping.val) return mapping.opt;
+    uint8_t index = horizontal_swing_options::FROM_WIRE[mode];
+    if (index == OPTION_NONE) {
+        ESP_LOGW(TAG, "Received unknown horizontal swing mode");
+        return horizontal_swing_options::OFF;
     }
-
-    ESP_LOGW(TAG, "Received unknown horizontal swing mode");
-    return horizontal_swing_options::OFF;
+    return index;
 }
 
-const char* GreeACCNT::determine_display()
+uint8_t GreeACCNT::determine_display()
 {
     uint8_t mode = (this->serialProcess_.data[protocol::REPORT_DISP_MODE_BYTE] & protocol::REPORT_DISP_MODE_MASK) >> protocol::REPORT_DISP_MODE_POS;
 
-    switch (mode) {
-        case protocol::REPORT_DISP_MODE_SET:
-            return display_options::SET;
-        case protocol::REPORT_DISP_MODE_ACT:
-            return display_options::ACT;
-        case protocol::REPORT_DISP_MODE_OUT:
-            ESP_LOGW(TAG, "Outside temperature display mode is not supported and was requested by the unit. Falling back to Set temperature.");
-            return display_options::SET;
-        default:
-            ESP_LOGW(TAG, "Received unknown display mode: %d. Falling back to Set temperature.", mode);
-            return display_options::SET;
+    uint8_t index = display_options::FROM_WIRE[mode];
+    if (index != OPTION_NONE)
+        return index;
+
+    if (mode == protocol::REPORT_DISP_MODE_OUT) {
+        ESP_LOGW(TAG, "Outside temperature display mode is not supported and was requested by the unit. Falling back to Set temperature.");
+    } else {
+        ESP_LOGW(TAG, "Received unknown display mode: %d. Falling back to Set temperature.", mode);
     }
+    return display_options::SET;
 }
 
 bool GreeACCNT::determine_light()
@@ -944,7 +1132,7 @@ bool GreeACCNT::determine_light()
     return (this->serialProcess_.data[protocol::REPORT_DISP_ON_BYTE] & protocol::REPORT_DISP_ON_MASK) != 0;
 }
 
-const char* GreeACCNT::determine_display_unit()
+uint8_t GreeACCNT::determine_display_unit()
 {
     if (this->serialProcess_.data[protocol::REPORT_DISP_F_BYTE] & protocol::REPORT_DISP_F_MASK)
     {
@@ -986,12 +1174,12 @@ bool GreeACCNT::determine_ifeel(){
     return (this->serialProcess_.data[protocol::REPORT_IFEEL_BYTE] & protocol::REPORT_IFEEL_MASK) != 0;
 }
 
-const char* GreeACCNT::determine_quiet(){
-    if (this->serialProcess_.data[protocol::REPORT_FAN_QUIET_BYTE] & protocol::REPORT_FAN_QUIET_MASK)
-        return quiet_options::ON;
-    if (this->serialProcess_.data[protocol::REPORT_FAN_QUIET_BYTE] & protocol::REPORT_FAN_QUIET_AUTO_MASK)
-        return quiet_options::AUTO;
-    return quiet_options::OFF;
+uint8_t GreeACCNT::determine_quiet(){
+    uint8_t quiet = this->serialProcess_.data[protocol::REPORT_FAN_QUIET_BYTE] & (protocol::REPORT_FAN_QUIET_MASK | protocol::REPORT_FAN_QUIET_AUTO_MASK);
+    /* both bits set reads as on */
+    if (quiet & protocol::REPORT_FAN_QUIET_MASK)
+        quiet = protocol::REPORT_FAN_QUIET_MASK;
+    return quiet_options::FROM_WIRE[quiet];
 }
 
 
@@ -999,7 +1187,7 @@ const char* GreeACCNT::determine_quiet(){
  * Sensor handling
  */
 
-void GreeACCNT::on_vertical_swing_change(const std::string &swing)
+void GreeACCNT::on_vertical_swing_change(uint8_t swing)
 {
     if (this->state_ != ACState::Ready)
         return;
@@ -1010,7 +1198,7 @@ void GreeACCNT::on_vertical_swing_change(const std::string &swing)
     this->vertical_swing_state_ = swing;
 }
 
-void GreeACCNT::on_horizontal_swing_change(const std::string &swing)
+void GreeACCNT::on_horizontal_swing_change(uint8_t swing)
 {
     if (this->state_ != ACState::Ready)
         return;
@@ -1021,7 +1209,7 @@ void GreeACCNT::on_horizontal_swing_change(const std::string &swing)
     this->horizontal_swing_state_ = swing;
 }
 
-void GreeACCNT::on_display_change(const std::string &display)
+void GreeACCNT::on_display_change(uint8_t display)
 {
     if (this->state_ != ACState::Ready)
         return;
@@ -1032,7 +1220,7 @@ void GreeACCNT::on_display_change(const std::string &display)
     this->display_state_ = display;
 }
 
-void GreeACCNT::on_display_unit_change(const std::string &display_unit)
+void GreeACCNT::on_display_unit_change(uint8_t display_unit)
 {
     if (this->state_ != ACState::Ready)
         return;
@@ -1043,12 +1231,12 @@ void GreeACCNT::on_display_unit_change(const std::string &display_unit)
     this->display_unit_state_ = display_unit;
 }
 
-void GreeACCNT::on_light_mode_change(const std::string &mode)
+void GreeACCNT::on_light_mode_change(uint8_t mode)
 {
     if (this->state_ != ACState::Ready)
         return;
 
-    ESP_LOGD(TAG, "Setting light mode to %s", mode.c_str());
+    ESP_LOGD(TAG, "Setting light mode to %s", option_name(light_options::OPTIONS, mode));
 
     this->mark_for_update_();
     this->light_mode_ = mode;
@@ -1149,7 +1337,7 @@ void GreeACCNT::on_ifeel_change(bool ifeel)
     this->ifeel_state_ = ifeel;
 }
 
-void GreeACCNT::on_quiet_change(const std::string &quiet)
+void GreeACCNT::on_quiet_change(uint8_t quiet)
 {
     if (this->state_ != ACState::Ready)
         return;
@@ -1160,7 +1348,7 @@ void GreeACCNT::on_quiet_change(const std::string &quiet)
     this->quiet_state_ = quiet;
 
     /* Requirement 1: when gets on/auto then turbo must go off. */
-    if (quiet != quiet_options::OFF) {
+    if (this->quiet_state_ != quiet_options::OFF) {
         this->update_turbo(false);
     }
 }
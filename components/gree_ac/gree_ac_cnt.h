@@ -20,144 +20,45 @@ enum class ACUpdate {
     UpdateClear, /* update without 0xAF and cleared static flag */
 };
 
-namespace protocol {
-    /* SYNC */
-    static const uint8_t SYNC                = 0x7E;
-    /* packet types */
-    static const uint8_t CMD_IN_UNIT_REPORT  = 0x31;
-    static const uint8_t CMD_OUT_PARAMS_SET  = 0x01;
-    static const uint8_t CMD_OUT_SYNC_TIME   = 0x03;
-    static const uint8_t CMD_OUT_MAC_REPORT  = 0x04; /* 7e 7e 0d 04 04 00 00 00 AA BB CC DD EE FF 00 -> AA BB CC DD EE FF = MAC address */
-    static const uint8_t CMD_OUT_UNKNOWN_1   = 0x02; /* 7e 7e 10 02 00 00 00 00 00 00 03 00 28 1e 19 23 23 00 ba */
-    static const uint8_t CMD_IN_MODEL_ID     = 0x44; /* 7e 7e 1a 44 01 00 01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 01 */
-    static const uint8_t CMD_IN_UNKNOWN_2    = 0x33; /* 7e 7e 2f 33 00 00 40 00 09 20 19 0a 00 10 00 14 17 5b 08 08 00 00 00 00 00 00 00 00 01 00 00 0d 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 */
-
-    /* byte indexes are AFTER we remove first 4 bytes from the packet (sync, length, type) as well as a checksum */
-    /* unit report packet data fields, for binary values there is no need to define bit offset/position */
-    static const uint8_t REPORT_PWR_BYTE       = 4;
-    static const uint8_t REPORT_PWR_MASK       = 0b10000000;
-
-    static const uint8_t REPORT_MODE_BYTE      = 4;
-    static const uint8_t REPORT_MODE_MASK      = 0b01110000;
-    static const uint8_t REPORT_MODE_POS       = 4;
-    static const uint8_t REPORT_MODE_AUTO      = 0;
-    static const uint8_t REPORT_MODE_COOL      = 1;
-    static const uint8_t REPORT_MODE_DRY       = 2;
-    static const uint8_t REPORT_MODE_FAN       = 3;
-    static const uint8_t REPORT_MODE_HEAT      = 4;
-
-    static const uint8_t REPORT_FAN_SPD1_BYTE  = 18;
-    static const uint8_t REPORT_FAN_SPD1_MASK  = 0b00000111; //0b00001111;
-    static const uint8_t REPORT_FAN_SPD2_BYTE  = 4;
-    static const uint8_t REPORT_FAN_SPD2_MASK  = 0b00000111;
-    static const uint8_t REPORT_FAN_MODE_MASK  = 0b00000111;
-    static const uint8_t REPORT_FAN_QUIET_BYTE = 16;
-    static const uint8_t REPORT_FAN_QUIET_MASK = 0b00001000;
-    static const uint8_t REPORT_FAN_QUIET_AUTO_MASK = 0b00000100;
-    static const uint8_t REPORT_FAN_TURBO_BYTE = 6;
-    static const uint8_t REPORT_FAN_TURBO_MASK = 0b00000001;
-
-    static const uint8_t REPORT_TEMP_SET_BYTE  = 5;
-    static const uint8_t REPORT_TEMP_SET_MASK  = 0b11110000;
-    static const uint8_t REPORT_TEMP_SET_POS   = 4;
-    static const uint8_t REPORT_TEMP_SET_OFF   = 16; /* temperature offset from value in packet */
-
-    static const uint8_t REPORT_TEMP_ACT_BYTE  = 42;
-    static const uint8_t REPORT_TEMP_ACT_OFF   = 40; /* temperature offset from value in packet */
-
-    static const uint8_t REPORT_HSWING_BYTE    = 8;
-    static const uint8_t REPORT_HSWING_MASK    = 0b00000111;
-    static const uint8_t REPORT_HSWING_POS     = 0;
-    static const uint8_t REPORT_HSWING_OFF         = 0;
-    static const uint8_t REPORT_HSWING_FULL        = 1;
-    static const uint8_t REPORT_HSWING_CLEFT       = 2;
-    static const uint8_t REPORT_HSWING_CMIDL       = 3;
-    static const uint8_t REPORT_HSWING_CMID        = 4;
-    static const uint8_t REPORT_HSWING_CMIDR       = 5;
-    static const uint8_t REPORT_HSWING_CRIGHT      = 6;
-
-    static const uint8_t REPORT_VSWING_BYTE    = 8;
-    static const uint8_t REPORT_VSWING_MASK    = 0b11110000;
-    static const uint8_t REPORT_VSWING_POS     = 4;
-    static const uint8_t REPORT_VSWING_OFF         = 0;
-    static const uint8_t REPORT_VSWING_FULL        = 1;
-    static const uint8_t REPORT_VSWING_CUP         = 2;
-    static const uint8_t REPORT_VSWING_CMIDU       = 3;
-    static const uint8_t REPORT_VSWING_CMID        = 4;
-    static const uint8_t REPORT_VSWING_CMIDD       = 5;
-    static const uint8_t REPORT_VSWING_CDOWN       = 6;
-    static const uint8_t REPORT_VSWING_DOWN        = 7;
-    static const uint8_t REPORT_VSWING_MIDD        = 8;
-    static const uint8_t REPORT_VSWING_MID         = 9;
-    static const uint8_t REPORT_VSWING_MIDU        = 10;
-    static const uint8_t REPORT_VSWING_UP          = 11;
-
-    static const uint8_t REPORT_DISP_ON_BYTE   = 6;
-    static const uint8_t REPORT_DISP_ON_MASK   = 0b00000010;
-    static const uint8_t REPORT_DISP_MODE_BYTE = 9;
-    static const uint8_t REPORT_DISP_MODE_MASK = 0b00110000;
-    static const uint8_t REPORT_DISP_MODE_POS  = 4;
-    static const uint8_t REPORT_DISP_MODE_AUTO     = 0;
-    static const uint8_t REPORT_DISP_MODE_SET      = 1;
-    static const uint8_t REPORT_DISP_MODE_ACT      = 2;
-    static const uint8_t REPORT_DISP_MODE_OUT      = 3;
-
-    static const uint8_t REPORT_DISP_F_BYTE    = 7;
-    static const uint8_t REPORT_DISP_F_MASK    = 0b10000000;
-
-    static const uint8_t REPORT_IONIZER1_BYTE    = 6;
-    static const uint8_t REPORT_IONIZER1_MASK    = 0b00000100;
-    static const uint8_t REPORT_IONIZER2_BYTE    = 0;
-    static const uint8_t REPORT_IONIZER2_MASK    = 0b00000100;
-
-    static const uint8_t REPORT_SLEEP_BYTE       = 4;
-    static const uint8_t REPORT_SLEEP_MASK       = 0b00001000;
-
-    static const uint8_t REPORT_XFAN_BYTE        = 6;
-    static const uint8_t REPORT_XFAN_MASK        = 0b00001000;
-
-    static const uint8_t REPORT_POWERSAVE_BYTE   = 11;
-    static const uint8_t REPORT_POWERSAVE_MASK   = 0b01000000;
-
-    static const uint8_t REPORT_IFEEL_BYTE       = 9;
-    static const uint8_t REPORT_IFEEL_MASK       = 0b01000000;
-
-    static const uint8_t REPORT_BEEPER_BYTE    = 40;
-    static const uint8_t REPORT_BEEPER_MASK    = 0b00000001;
-
-    /* SET packet shares all the byte definition with REPORT */
-    static const uint8_t SET_PACKET_LEN        = 45;
-    
-    static const uint8_t SET_CONST_02_BYTE     = 39;
-    static const uint8_t SET_CONST_02_VAL      = 0x02;
-
-    static const uint8_t SET_AF_BYTE           = 3;
-    static const uint8_t SET_AF_VAL            = 0xAF;
-
-    static const uint8_t SET_NOCHANGE_BYTE     = 11;
-    static const uint8_t SET_NOCHANGE_MASK     = 0b00001000;
-
-    static const uint8_t SET_CONST_BIT_BYTE    = 7;
-    static const uint8_t SET_CONST_BIT_MASK    = 0b00000010;
-
-    /* time constraints */
-    static const unsigned long TIME_REFRESH_PERIOD_MS   =  330;
-    static const unsigned long TIME_MAC_CYCLE_PERIOD_MS = 60000;
-    static const unsigned long TIME_TIMEOUT_INACTIVE_MS = 10000;
-    static const unsigned long TIME_WAIT_RESPONSE_TIMEOUT_MS = 10000;
-}
+/* progress of the command being timed for the confirmation latency */
+enum class ACConfirm {
+    Idle,   /* nothing to confirm */
+    Queued, /* command received, update frame not sent yet */
+    Sent,   /* update frame sent, waiting for a report showing it */
+};
+
+/* number of heap allocations so far, see GreeACCNT::set_alloc_counter() */
+typedef uint32_t (*AllocCountFn_t)();
+
+/* parameter set applied by GreeACCNT::apply_scene(), unset fields keep their current value */
+struct SceneParams {
+    optional<climate::ClimateMode> mode;
+    optional<float> target_temperature;
+    optional<std::string> fan_mode;
+    optional<std::string> vertical_swing;
+    optional<std::string> horizontal_swing;
+    optional<std::string> quiet;
+    optional<bool> turbo;
+};
 
 class GreeACCNT : public GreeAC {
     public:
         void control(const climate::ClimateCall &call) override;
+        void apply_scene(const SceneParams &scene);
+        void run_benchmarks(uint16_t iterations);
+        /* with a counter set, every benchmark result also reports allocations per operation */
+        void set_alloc_counter(AllocCountFn_t counter) { this->alloc_counter_ = counter; }
+#ifdef GREE_AC_FOOTPRINT_REPORT
+        void log_footprint();
+#endif
 
-        void on_horizontal_swing_change(const std::string &swing) override;
-        void on_vertical_swing_change(const std::string &swing) override;
+        void on_horizontal_swing_change(uint8_t swing) override;
+        void on_vertical_swing_change(uint8_t swing) override;
 
-        void on_display_change(const std::string &display) override;
-        void on_display_unit_change(const std::string &display_unit) override;
+        void on_display_change(uint8_t display) override;
+        void on_display_unit_change(uint8_t display_unit) override;
 
-        void on_light_mode_change(const std::string &mode) override;
+        void on_light_mode_change(uint8_t mode) override;
         void on_ionizer_change(bool ionizer) override;
         void on_beeper_change(bool beeper) override;
         void on_sleep_change(bool sleep) override;
@@ -165,7 +66,7 @@ class GreeACCNT : public GreeAC {
         void on_powersave_change(bool powersave) override;
         void on_turbo_change(bool turbo) override;
         void on_ifeel_change(bool ifeel) override;
-        void on_quiet_change(const std::string &quiet) override;
+        void on_quiet_change(uint8_t quiet) override;
 
         void setup() override;
         void loop() override;
@@ -175,7 +76,9 @@ class GreeACCNT : public GreeAC {
         void finalize_checksum_(uint8_t *data, size_t len);
         bool verify_checksum_(const uint8_t *data, size_t len);
 
+        bool tx_due_soon_(uint32_t now);
         void mark_for_update_();
+        void check_confirmation_();
 
         ACState state_ = ACState::Initializing; /* Stores if the AC is responsive or not */
         ACUpdate update_ = ACUpdate::NoUpdate;  /* Stores if we need tu send update to AC or no */
@@ -185,6 +88,11 @@ class GreeACCNT : public GreeAC {
         uint32_t last_mac_sequence_millis_ = 0;
         uint32_t last_sync_time_sent_ = 0;
         uint32_t last_packet_duration_ms_ = 0;
+        uint8_t mac_report_frame_[protocol::MAC_REPORT_PAYLOAD_LEN + 5];  /* built in setup() */
+
+        ACConfirm confirm_ = ACConfirm::Idle;
+        uint32_t confirm_start_ = 0;                          /* time of the command being timed */
+        uint8_t confirm_expected_[protocol::SET_PACKET_LEN];  /* payload of the update frame carrying it */
 
         climate::ClimateMode mode_internal_;
         bool power_internal_;
@@ -195,6 +103,7 @@ class GreeACCNT : public GreeAC {
         bool processUnitReport();
 
         void send_params_set_packet();
+        void build_params_set_packet_(uint8_t *packet);
         void send_mac_report_packet();
         void send_sync_time_packet();
         void send_special_startup_packet();
@@ -203,17 +112,69 @@ class GreeACCNT : public GreeAC {
 
         bool reqmodechange = false;
 
-        bool verify_packet();
+        uint8_t last_report_[protocol::SET_PACKET_LEN] = {};  /* payload of the last unit report, for run_benchmarks() and excluded fields */
+        bool has_last_report_ = false;
+
+        /* everything processUnitReport() writes, saved and restored around run_benchmarks() */
+        typedef struct {
+            SerialProcess_t serial;
+            climate::ClimateMode mode;
+            float target_temperature;
+            float current_temperature;
+            optional<climate::ClimateFanMode> fan_mode;
+            const char *custom_fan_mode;
+            climate::ClimateSwingMode swing_mode;
+            climate::ClimateMode mode_internal;
+            bool power_internal;
+            uint8_t vertical_swing;
+            uint8_t horizontal_swing;
+            uint8_t display;
+            uint8_t display_unit;
+            uint8_t quiet;
+            uint8_t light_mode;
+            bool light;
+            bool ionizer;
+            bool beeper;
+            bool sleep;
+            bool xfan;
+            bool powersave;
+            bool turbo;
+            bool ifeel;
+            ACUpdate update;
+            bool reqmodechange;
+            uint16_t publish_pending;
+            uint16_t publish_forced;
+        } DecodedState_t;
+        void save_decoded_state_(DecodedState_t *state);
+        void restore_decoded_state_(const DecodedState_t &state);
+        AllocCountFn_t alloc_counter_ = nullptr;
+
+        bool verify_packet(bool checksum_ok);
         void handle_packet();
+        void handle_unit_report_();
+        void handle_model_id_();
+
+        typedef void (GreeACCNT::*PacketHandler_t)();
+        typedef struct {
+            uint8_t cmd;
+            uint8_t min_size;
+            PacketHandler_t handler;
+        } InboundPacket_t;
+        static const InboundPacket_t INBOUND_PACKETS[];
+        typedef struct {
+            uint8_t slot[256];  /* command byte -> 1 + index into INBOUND_PACKETS, 0 = not decoded */
+        } InboundSlots_t;
+        static const InboundSlots_t INBOUND_SLOTS;  /* PROGMEM, built at compile time */
+        static constexpr InboundSlots_t build_inbound_slots_();
 
         climate::ClimateMode determine_mode();
-        const char* determine_fan_mode();
+        uint8_t determine_fan_mode();
 
-        const char* determine_vertical_swing();
-        const char* determine_horizontal_swing();
+        uint8_t determine_vertical_swing();
+        uint8_t determine_horizontal_swing();
 
-        const char* determine_display();
-        const char* determine_display_unit();
+        uint8_t determine_display();
+        uint8_t determine_display_unit();
 
         bool determine_light();
         bool determine_ionizer();
@@ -223,7 +184,7 @@ class GreeACCNT : public GreeAC {
         bool determine_powersave();
         bool determine_turbo();
         bool determine_ifeel();
-        const char* determine_quiet();
+        uint8_t determine_quiet();
 };
 
 }  // namespace CNT
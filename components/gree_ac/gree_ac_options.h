@@ -0,0 +1,250 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esphome/core/hal.h"
+#include "gree_ac_protocol.h"
+
+/*
+ * Option sets of the selects and fan speeds, one constexpr table each. The position in OPTIONS is the option
+ * index (same order as the select in Home Assistant), name is the label and wire the value of the field in
+ * unit reports and set frames. FROM_WIRE maps a decoded field back to the index, so both directions are a
+ * single array access.
+ *
+ * climate.py keeps its own *_OPTIONS lists to build the selects and emits static_asserts against these
+ * tables into main.cpp, so the two sides cannot drift apart without a compile error.
+ *
+ * All tables are PROGMEM, so on ESP8266 they stay in flash instead of taking DRAM, and inline, so the linker
+ * keeps one copy for all translation units instead of one per file including this header. Flash there can only be
+ * read with aligned 32 bit loads, so everything read at runtime goes through progmem_read_byte(); names may
+ * be passed to a printf style "%s", which reads PROGMEM safely, but not to ESPHome APIs keeping the pointer.
+ */
+
+namespace esphome {
+namespace gree_ac {
+
+/* longest label plus terminator, "Constant - Mid-Right"; a longer one does not compile */
+static const size_t OPTION_NAME_SIZE = 21;
+
+/* the label is stored in the entry, so it goes to flash together with the table */
+struct OptionDef {
+    char name[OPTION_NAME_SIZE];
+    uint8_t wire;
+};
+
+/* index of no option, e.g. before the first report or for a name which is not in the table */
+static const uint8_t OPTION_NONE = 0xFF;
+
+constexpr bool option_name_equal(const char *a, const char *b)
+{
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/* names are unique, wire values are unique and below wire_limit */
+template<size_t N> constexpr bool options_valid(const OptionDef (&options)[N], size_t wire_limit)
+{
+    for (size_t i = 0; i < N; i++) {
+        if (options[i].name[0] == '\0' || options[i].wire >= wire_limit)
+            return false;
+        for (size_t j = i + 1; j < N; j++) {
+            if (options[i].wire == options[j].wire || option_name_equal(options[i].name, options[j].name))
+                return false;
+        }
+    }
+    return true;
+}
+
+/* option_name_equal() for a name in PROGMEM and one in RAM */
+inline bool option_name_equal_P(const char *progmem_name, const char *name)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(progmem_name);
+    uint8_t c;
+    while ((c = progmem_read_byte(p)) != '\0' && c == static_cast<uint8_t>(*name)) {
+        p++;
+        name++;
+    }
+    return c == static_cast<uint8_t>(*name);
+}
+
+/* memcpy out of a PROGMEM table */
+inline void progmem_copy(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        dst[i] = progmem_read_byte(src + i);
+}
+
+/* a field of a report or set frame, for the tables which walk several of them */
+typedef struct {
+    uint8_t byte;
+    uint8_t mask;
+} FieldMask_t;
+
+inline FieldMask_t read_field_mask(const FieldMask_t *entry)
+{
+    return {progmem_read_byte(&entry->byte), progmem_read_byte(&entry->mask)};
+}
+
+/* name to index for strings from the config or automations, never on the per frame path */
+template<size_t N> uint8_t option_index(const OptionDef (&options)[N], const char *name)
+{
+    for (size_t i = 0; i < N; i++) {
+        if (option_name_equal_P(options[i].name, name))
+            return i;
+    }
+    return OPTION_NONE;
+}
+
+/* label of an option, "" for OPTION_NONE; points into PROGMEM, for "%s" only */
+template<size_t N> const char *option_name(const OptionDef (&options)[N], uint8_t index)
+{
+    return index < N ? options[index].name : "";
+}
+
+/* wire value of an option, fallback for OPTION_NONE */
+template<size_t N> uint8_t option_wire(const OptionDef (&options)[N], uint8_t index, uint8_t fallback)
+{
+    return index < N ? progmem_read_byte(&options[index].wire) : fallback;
+}
+
+/* wire value -> option index, filled at compile time; values without an option map to OPTION_NONE */
+template<size_t W> struct WireLookup {
+    uint8_t index[W];
+
+    template<size_t N> constexpr WireLookup(const OptionDef (&options)[N]) : index{}
+    {
+        for (size_t i = 0; i < W; i++)
+            this->index[i] = OPTION_NONE;
+        for (size_t i = 0; i < N; i++)
+            this->index[options[i].wire] = i;
+    }
+
+    uint8_t operator[](uint8_t wire) const { return wire < W ? progmem_read_byte(&this->index[wire]) : OPTION_NONE; }
+};
+
+/* FAN_MODE_OPTIONS in climate.py, wire is the REPORT_FAN_SPD1 value */
+namespace fan_modes {
+    enum : uint8_t { FAN_AUTO, FAN_MIN, FAN_LOW, FAN_MED, FAN_HIGH, FAN_MAX, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"Auto",    0x00},
+        {"Minimum", 0x01},
+        {"Low",     0x02},
+        {"Medium",  0x03},
+        {"High",    0x04},
+        {"Maximum", 0x05},
+    };
+    static_assert(options_valid(OPTIONS, CNT::protocol::REPORT_FAN_SPD1_MASK + 1), "fan mode table");
+
+    /* the REPORT_FAN_SPD2 bits which go with each speed */
+    inline constexpr uint8_t SPD2[COUNT] PROGMEM = {0x00, 0x01, 0x02, 0x02, 0x03, 0x03};
+
+    /* ClimateTraits keeps pointers to the custom fan mode names and compares them, so these two stay in RAM */
+    inline constexpr const char *MIN_NAME = "Minimum";
+    inline constexpr const char *MAX_NAME = "Maximum";
+    static_assert(option_name_equal(OPTIONS[FAN_MIN].name, MIN_NAME) && option_name_equal(OPTIONS[FAN_MAX].name, MAX_NAME),
+                  "custom fan mode names");
+
+    inline constexpr WireLookup<CNT::protocol::REPORT_FAN_SPD1_MASK + 1> FROM_WIRE PROGMEM{OPTIONS};
+}
+
+/* QUIET_OPTIONS in climate.py, wire is the bits in REPORT_FAN_QUIET_BYTE */
+namespace quiet_options {
+    enum : uint8_t { OFF, ON, AUTO, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"Off",  0},
+        {"On",   CNT::protocol::REPORT_FAN_QUIET_MASK},
+        {"Auto", CNT::protocol::REPORT_FAN_QUIET_AUTO_MASK},
+    };
+    static_assert(options_valid(OPTIONS, 16), "quiet table");
+
+    inline constexpr WireLookup<16> FROM_WIRE PROGMEM{OPTIONS};
+}
+
+/* HORIZONTAL_SWING_OPTIONS in climate.py */
+namespace horizontal_swing_options {
+    enum : uint8_t { OFF, FULL, CLEFT, CMIDL, CMID, CMIDR, CRIGHT, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"Off",                  CNT::protocol::REPORT_HSWING_OFF},
+        {"Swing - Full",         CNT::protocol::REPORT_HSWING_FULL},
+        {"Constant - Left",      CNT::protocol::REPORT_HSWING_CLEFT},
+        {"Constant - Mid-Left",  CNT::protocol::REPORT_HSWING_CMIDL},
+        {"Constant - Middle",    CNT::protocol::REPORT_HSWING_CMID},
+        {"Constant - Mid-Right", CNT::protocol::REPORT_HSWING_CMIDR},
+        {"Constant - Right",     CNT::protocol::REPORT_HSWING_CRIGHT},
+    };
+    static_assert(options_valid(OPTIONS, (CNT::protocol::REPORT_HSWING_MASK >> CNT::protocol::REPORT_HSWING_POS) + 1),
+                  "horizontal swing table");
+
+    inline constexpr WireLookup<(CNT::protocol::REPORT_HSWING_MASK >> CNT::protocol::REPORT_HSWING_POS) + 1> FROM_WIRE PROGMEM{OPTIONS};
+}
+
+/* VERTICAL_SWING_OPTIONS in climate.py */
+namespace vertical_swing_options {
+    enum : uint8_t { OFF, FULL, DOWN, MIDD, MID, MIDU, UP, CDOWN, CMIDD, CMID, CMIDU, CUP, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"Off",                 CNT::protocol::REPORT_VSWING_OFF},
+        {"Swing - Full",        CNT::protocol::REPORT_VSWING_FULL},
+        {"Swing - Down",        CNT::protocol::REPORT_VSWING_DOWN},
+        {"Swing - Mid-Down",    CNT::protocol::REPORT_VSWING_MIDD},
+        {"Swing - Middle",      CNT::protocol::REPORT_VSWING_MID},
+        {"Swing - Mid-Up",      CNT::protocol::REPORT_VSWING_MIDU},
+        {"Swing - Up",          CNT::protocol::REPORT_VSWING_UP},
+        {"Constant - Down",     CNT::protocol::REPORT_VSWING_CDOWN},
+        {"Constant - Mid-Down", CNT::protocol::REPORT_VSWING_CMIDD},
+        {"Constant - Middle",   CNT::protocol::REPORT_VSWING_CMID},
+        {"Constant - Mid-Up",   CNT::protocol::REPORT_VSWING_CMIDU},
+        {"Constant - Up",       CNT::protocol::REPORT_VSWING_CUP},
+    };
+    static_assert(options_valid(OPTIONS, (CNT::protocol::REPORT_VSWING_MASK >> CNT::protocol::REPORT_VSWING_POS) + 1),
+                  "vertical swing table");
+
+    inline constexpr WireLookup<(CNT::protocol::REPORT_VSWING_MASK >> CNT::protocol::REPORT_VSWING_POS) + 1> FROM_WIRE PROGMEM{OPTIONS};
+}
+
+/* DISPLAY_OPTIONS in climate.py, the unit also knows "auto" and "outside", which are not offered */
+namespace display_options {
+    enum : uint8_t { SET, ACT, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"Set temperature",    CNT::protocol::REPORT_DISP_MODE_SET},
+        {"Actual temperature", CNT::protocol::REPORT_DISP_MODE_ACT},
+    };
+    static_assert(options_valid(OPTIONS, (CNT::protocol::REPORT_DISP_MODE_MASK >> CNT::protocol::REPORT_DISP_MODE_POS) + 1),
+                  "display table");
+
+    inline constexpr WireLookup<(CNT::protocol::REPORT_DISP_MODE_MASK >> CNT::protocol::REPORT_DISP_MODE_POS) + 1> FROM_WIRE PROGMEM{OPTIONS};
+}
+
+/* DISPLAY_UNIT_OPTIONS in climate.py, wire is the REPORT_DISP_F bit */
+namespace display_unit_options {
+    enum : uint8_t { DEGC, DEGF, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"C", 0},
+        {"F", 1},
+    };
+    static_assert(options_valid(OPTIONS, 2), "display unit table");
+}
+
+/* LIGHT_OPTIONS in climate.py; a policy for the display light bit, so wire is only the index */
+namespace light_options {
+    enum : uint8_t { OFF, ON, AUTO, COUNT };
+
+    inline constexpr OptionDef OPTIONS[COUNT] PROGMEM = {
+        {"Off",  OFF},
+        {"On",   ON},
+        {"Auto", AUTO},
+    };
+    static_assert(options_valid(OPTIONS, COUNT), "light table");
+}
+
+}  // namespace gree_ac
+}  // namespace esphome
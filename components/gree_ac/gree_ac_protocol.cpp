@@ -0,0 +1,190 @@
+#include "gree_ac_protocol.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace esphome {
+namespace gree_ac {
+
+void serial_process_reset(SerialProcess_t *sp)
+{
+    sp->size = 0;
+    sp->state = STATE_WAIT_SYNC;
+    sp->discarded = 0;
+}
+
+bool serial_process_feed(SerialProcess_t *sp, uint8_t c)
+{
+    sp->data[sp->size++] = c;
+    size_t s = sp->size;
+
+    // Check for sync marker within packet (resync)
+    if (s >= 2 && sp->data[s-2] == 0x7E && sp->data[s-1] == 0x7E) {
+        if (s > 2) {
+            sp->discarded += s - 2;
+            sp->data[0] = 0x7E;
+            sp->data[1] = 0x7E;
+            sp->size = 2;
+            s = 2;
+        }
+    } else if (s == 1 && sp->data[0] != 0x7E) {
+        sp->discarded += 1;
+        sp->size = 0;
+        return false;
+    } else if (s == 2 && sp->data[0] == 0x7E && sp->data[1] != 0x7E) {
+        sp->discarded += 2;
+        sp->size = 0;
+        return false;
+    }
+
+    if (s == 3) {
+        sp->frame_size = c;
+    }
+
+    if (s >= 3 && s == (size_t)(sp->frame_size + 3)) {
+        sp->state = STATE_COMPLETE;
+    }
+
+    /* a frame of exactly FRAME_DATA_MAX bytes still fits */
+    if (s >= FRAME_DATA_MAX && sp->state != STATE_COMPLETE) {
+        sp->discarded += s;
+        sp->size = 0;
+    }
+
+    return sp->state == STATE_COMPLETE;
+}
+
+bool FrameQueue::push(const uint8_t *data, uint8_t size, bool checksum_ok, uint32_t discarded, uint32_t time_ms,
+                      uint32_t time_us, uint32_t first_us)
+{
+    uint32_t head = this->head_.load(std::memory_order_relaxed);
+    if (head - this->tail_.load(std::memory_order_acquire) >= SLOTS) {
+        this->dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    QueuedFrame_t &slot = this->slots_[head % SLOTS];
+    memcpy(slot.data, data, size);
+    slot.size = size;
+    slot.checksum_ok = checksum_ok;
+    slot.discarded = discarded;
+    slot.time_ms = time_ms;
+    slot.time_us = time_us;
+    slot.first_us = first_us;
+    this->head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+const QueuedFrame_t *FrameQueue::front() const
+{
+    uint32_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (this->head_.load(std::memory_order_acquire) == tail)
+        return nullptr;
+    return &this->slots_[tail % SLOTS];
+}
+
+void FrameQueue::pop()
+{
+    this->tail_.store(this->tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint8_t RecoveryStats::bucket_(uint32_t value)
+{
+    uint8_t bucket = 0;
+    while (value != 0 && bucket < BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void RecoveryStats::record(uint32_t bytes, uint32_t ms)
+{
+    this->count_++;
+    this->bytes_hist_[bucket_(bytes)]++;
+    this->ms_hist_[bucket_(ms)]++;
+    if (bytes > this->max_bytes_)
+        this->max_bytes_ = bytes;
+    if (ms > this->max_ms_)
+        this->max_ms_ = ms;
+}
+
+void RecoveryStats::clear()
+{
+    *this = RecoveryStats();
+}
+
+static void append_json_list(char *out, size_t out_size, size_t &pos, const char *key, const uint32_t *values, uint8_t count)
+{
+    for (uint8_t i = 0; i < count && pos < out_size; i++) {
+        int written = i == 0 ? snprintf(&out[pos], out_size - pos, ",\"%s\":[%u", key, (unsigned) values[i])
+                             : snprintf(&out[pos], out_size - pos, ",%u", (unsigned) values[i]);
+        if (written > 0)
+            pos += (size_t) written;
+    }
+    if (pos < out_size)
+        pos += snprintf(&out[pos], out_size - pos, "]");
+}
+
+size_t RecoveryStats::format_json(char *out, size_t out_size) const
+{
+    if (out_size == 0)
+        return 0;
+
+    int written = snprintf(out, out_size, "{\"n\":%u,\"max_bytes\":%u,\"max_ms\":%u",
+                           (unsigned) this->count_, (unsigned) this->max_bytes_, (unsigned) this->max_ms_);
+    size_t pos = written > 0 ? (size_t) written : 0;
+    append_json_list(out, out_size, pos, "bytes", this->bytes_hist_, BUCKETS);
+    append_json_list(out, out_size, pos, "ms", this->ms_hist_, BUCKETS);
+    if (pos < out_size)
+        pos += snprintf(&out[pos], out_size - pos, "}");
+
+    return pos < out_size ? pos : out_size - 1;
+}
+
+const uint16_t LatencyHistogram::BOUNDS_MS[BUCKETS - 1] = {
+    100, 200, 300, 400, 500, 750, 1000, 1500, 2000, 3000, 5000
+};
+
+void LatencyHistogram::record(uint32_t ms)
+{
+    uint8_t bucket = 0;
+    while (bucket < BUCKETS - 1 && ms > BOUNDS_MS[bucket])
+        bucket++;
+
+    this->hist_[bucket]++;
+    this->total_++;
+    this->count_++;
+    if (ms > this->max_ms_)
+        this->max_ms_ = ms;
+
+    if (this->total_ >= AGE_COUNT) {
+        this->total_ = 0;
+        for (uint16_t &n : this->hist_) {
+            n /= 2;
+            this->total_ += n;
+        }
+    }
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const
+{
+    if (this->total_ == 0)
+        return 0;
+
+    /* rank of the sample, rounded up, so p50 of a single sample is that sample */
+    uint32_t rank = ((uint32_t) this->total_ * percent + 99) / 100;
+    if (rank == 0)
+        rank = 1;
+
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < BUCKETS - 1; bucket++) {
+        seen += this->hist_[bucket];
+        if (seen >= rank)
+            return BOUNDS_MS[bucket];
+    }
+    return this->max_ms_;
+}
+
+}  // namespace gree_ac
+}  // namespace esphome
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Protocol core: frame synchronizer, checksum and the wire constants.
+ * Nothing in here depends on ESPHome or Arduino, so it builds and runs on a host as well:
+ *   g++ -std=gnu++17 -c components/gree_ac/gree_ac_protocol.cpp
+ */
+
+namespace esphome {
+namespace gree_ac {
+
+/* receive buffer size, the synchronizer drops everything longer than this */
+static const uint8_t FRAME_DATA_MAX = 200;
+
+typedef enum {
+        STATE_WAIT_SYNC,
+        STATE_RECIEVE,
+        STATE_COMPLETE,
+        STATE_RESTART
+} SerialProcessState_t;
+
+typedef struct {
+  uint8_t data[FRAME_DATA_MAX];
+  size_t size;
+  uint8_t frame_size;
+  SerialProcessState_t state;
+  uint32_t last_byte_time;
+  uint16_t discarded;   // bytes thrown away while looking for sync, the caller collects and clears it
+} SerialProcess_t;
+
+/* drops any partial frame and waits for the next 7E.7E */
+void serial_process_reset(SerialProcess_t *sp);
+
+/*
+ * feeds one received byte into the synchronizer, returns true once sp->data holds a complete frame
+ * (state STATE_COMPLETE). The caller has to reset it after handling the frame.
+ */
+bool serial_process_feed(SerialProcess_t *sp, uint8_t c);
+
+/* a complete frame as handed from the RX task to the main loop, see FrameQueue */
+typedef struct {
+  uint8_t data[FRAME_DATA_MAX];
+  uint8_t size;
+  bool checksum_ok;     // checked by the producer already
+  uint32_t discarded;   // bytes the synchronizer threw away since the previous frame
+  uint32_t time_ms;     // last byte received
+  uint32_t time_us;     // same, for the trace
+  uint32_t first_us;    // first byte received, for the trace
+} QueuedFrame_t;
+
+/*
+ * Lock-free queue of received frames between exactly one producer (the RX task) and one consumer (the main loop).
+ * Each side only ever stores its own index, acquire/release on the other one makes the slot contents visible.
+ * A full queue drops the new frame and counts it, the producer never waits for the consumer.
+ * Only std::atomic is used, so a host test can drive both ends from two std::threads.
+ */
+class FrameQueue {
+    public:
+        static const uint8_t SLOTS = 8;  // power of two, 8 unit reports are ~2.5 s of traffic at the refresh period
+
+        /* producer: copies the frame into the next free slot, false (and counted) if the queue is full */
+        bool push(const uint8_t *data, uint8_t size, bool checksum_ok, uint32_t discarded, uint32_t time_ms, uint32_t time_us,
+                  uint32_t first_us);
+
+        /* consumer: oldest frame or nullptr, stays valid until pop() */
+        const QueuedFrame_t *front() const;
+        void pop();
+
+        /* frames lost to a full queue since boot */
+        uint32_t dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+
+    protected:
+        QueuedFrame_t slots_[SLOTS];
+        std::atomic<uint32_t> head_{0};     // frames pushed, written by the producer only
+        std::atomic<uint32_t> tail_{0};     // frames popped, written by the consumer only
+        std::atomic<uint32_t> dropped_{0};
+};
+
+/*
+ * Distribution of how long it takes to get valid framing back after it was lost, in bytes thrown away
+ * (discarded by the synchronizer or part of invalid frames) and in ms until the next valid frame.
+ * Buckets are log2: 0, 1, 2-3, 4-7, ... and everything from 2^(BUCKETS-2) up in the last one.
+ */
+class RecoveryStats {
+    public:
+        static const uint8_t BUCKETS = 12;
+
+        void record(uint32_t bytes, uint32_t ms);
+        void clear();
+        /* {"n":..,"max_bytes":..,"max_ms":..,"bytes":[..],"ms":[..]}, returns the number of chars written */
+        size_t format_json(char *out, size_t out_size) const;
+
+        uint32_t count() const { return this->count_; }
+
+    protected:
+        static uint8_t bucket_(uint32_t value);
+
+        uint32_t count_ = 0;
+        uint32_t max_bytes_ = 0;
+        uint32_t max_ms_ = 0;
+        uint32_t bytes_hist_[BUCKETS] = {};
+        uint32_t ms_hist_[BUCKETS] = {};
+};
+
+/*
+ * Latency distribution in ms with fixed buckets, for the time from a command to the unit report confirming it.
+ * Percentiles resolve to the upper bound of their bucket, max is exact. Every AGE_COUNT samples all buckets
+ * are halved, so the percentiles follow the recent behaviour instead of the whole uptime.
+ */
+class LatencyHistogram {
+    public:
+        static const uint8_t BUCKETS = 12;
+        static const uint16_t AGE_COUNT = 256;
+
+        void record(uint32_t ms);
+        /* upper bound of the bucket holding the given percentile, max() for the open last bucket, 0 without samples */
+        uint32_t percentile(uint8_t percent) const;
+
+        uint32_t max() const { return this->max_ms_; }
+        uint32_t count() const { return this->count_; }
+
+    protected:
+        static const uint16_t BOUNDS_MS[BUCKETS - 1];
+
+        uint32_t count_ = 0;   // samples recorded since boot
+        uint32_t max_ms_ = 0;  // since boot, not aged
+        uint16_t total_ = 0;   // samples currently in the buckets
+        uint16_t hist_[BUCKETS] = {};
+};
+
+/* sum of all bytes from the length byte up to (not including) the checksum byte of a whole frame */
+constexpr uint8_t frame_checksum(const uint8_t *data, size_t len)
+{
+    uint8_t checksum = 0;
+    for (size_t i = 2; i < len - 1; i++) {
+        checksum += data[i];
+    }
+    return checksum;
+}
+
+namespace CNT {
+
+namespace protocol {
+    /* SYNC */
+    static const uint8_t SYNC                = 0x7E;
+    /* packet types */
+    static const uint8_t CMD_IN_UNIT_REPORT  = 0x31;
+    static const uint8_t CMD_OUT_PARAMS_SET  = 0x01;
+    static const uint8_t CMD_OUT_SYNC_TIME   = 0x03;
+    static const uint8_t CMD_OUT_MAC_REPORT  = 0x04; /* 7e 7e 0d 04 04 00 00 00 AA BB CC DD EE FF 00 -> AA BB CC DD EE FF = MAC address */
+    static const uint8_t CMD_OUT_UNKNOWN_1   = 0x02; /* 7e 7e 10 02 00 00 00 00 00 00 03 00 28 1e 19 23 23 00 ba */
+    static const uint8_t CMD_IN_MODEL_ID     = 0x44; /* 7e 7e 1a 44 01 00 01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 01 */
+    static const uint8_t CMD_IN_UNKNOWN_2    = 0x33; /* 7e 7e 2f 33 00 00 40 00 09 20 19 0a 00 10 00 14 17 5b 08 08 00 00 00 00 00 00 00 00 01 00 00 0d 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 */
+
+    /* byte indexes are AFTER we remove first 4 bytes from the packet (sync, length, type) as well as a checksum */
+    /* unit report packet data fields, for binary values there is no need to define bit offset/position */
+    static const uint8_t REPORT_PWR_BYTE       = 4;
+    static const uint8_t REPORT_PWR_MASK       = 0b10000000;
+
+    static const uint8_t REPORT_MODE_BYTE      = 4;
+    static const uint8_t REPORT_MODE_MASK      = 0b01110000;
+    static const uint8_t REPORT_MODE_POS       = 4;
+    static const uint8_t REPORT_MODE_AUTO      = 0;
+    static const uint8_t REPORT_MODE_COOL      = 1;
+    static const uint8_t REPORT_MODE_DRY       = 2;
+    static const uint8_t REPORT_MODE_FAN       = 3;
+    static const uint8_t REPORT_MODE_HEAT      = 4;
+
+    static const uint8_t REPORT_FAN_SPD1_BYTE  = 18;
+    static const uint8_t REPORT_FAN_SPD1_MASK  = 0b00000111; //0b00001111;
+    static const uint8_t REPORT_FAN_SPD2_BYTE  = 4;
+    static const uint8_t REPORT_FAN_SPD2_MASK  = 0b00000111;
+    static const uint8_t REPORT_FAN_MODE_MASK  = 0b00000111;
+    static const uint8_t REPORT_FAN_QUIET_BYTE = 16;
+    static const uint8_t REPORT_FAN_QUIET_MASK = 0b00001000;
+    static const uint8_t REPORT_FAN_QUIET_AUTO_MASK = 0b00000100;
+    static const uint8_t REPORT_FAN_TURBO_BYTE = 6;
+    static const uint8_t REPORT_FAN_TURBO_MASK = 0b00000001;
+
+    static const uint8_t REPORT_TEMP_SET_BYTE  = 5;
+    static const uint8_t REPORT_TEMP_SET_MASK  = 0b11110000;
+    static const uint8_t REPORT_TEMP_SET_POS   = 4;
+    static const uint8_t REPORT_TEMP_SET_OFF   = 16; /* temperature offset from value in packet */
+
+    static const uint8_t REPORT_TEMP_ACT_BYTE  = 42;
+    static const uint8_t REPORT_TEMP_ACT_OFF   = 40; /* temperature offset from value in packet */
+
+    static const uint8_t REPORT_HSWING_BYTE    = 8;
+    static const uint8_t REPORT_HSWING_MASK    = 0b00000111;
+    static const uint8_t REPORT_HSWING_POS     = 0;
+    static const uint8_t REPORT_HSWING_OFF         = 0;
+    static const uint8_t REPORT_HSWING_FULL        = 1;
+    static const uint8_t REPORT_HSWING_CLEFT       = 2;
+    static const uint8_t REPORT_HSWING_CMIDL       = 3;
+    static const uint8_t REPORT_HSWING_CMID        = 4;
+    static const uint8_t REPORT_HSWING_CMIDR       = 5;
+    static const uint8_t REPORT_HSWING_CRIGHT      = 6;
+
+    static const uint8_t REPORT_VSWING_BYTE    = 8;
+    static const uint8_t REPORT_VSWING_MASK    = 0b11110000;
+    static const uint8_t REPORT_VSWING_POS     = 4;
+    static const uint8_t REPORT_VSWING_OFF         = 0;
+    static const uint8_t REPORT_VSWING_FULL        = 1;
+    static const uint8_t REPORT_VSWING_CUP         = 2;
+    static const uint8_t REPORT_VSWING_CMIDU       = 3;
+    static const uint8_t REPORT_VSWING_CMID        = 4;
+    static const uint8_t REPORT_VSWING_CMIDD       = 5;
+    static const uint8_t REPORT_VSWING_CDOWN       = 6;
+    static const uint8_t REPORT_VSWING_DOWN        = 7;
+    static const uint8_t REPORT_VSWING_MIDD        = 8;
+    static const uint8_t REPORT_VSWING_MID         = 9;
+    static const uint8_t REPORT_VSWING_MIDU        = 10;
+    static const uint8_t REPORT_VSWING_UP          = 11;
+
+    static const uint8_t REPORT_DISP_ON_BYTE   = 6;
+    static const uint8_t REPORT_DISP_ON_MASK   = 0b00000010;
+    static const uint8_t REPORT_DISP_MODE_BYTE = 9;
+    static const uint8_t REPORT_DISP_MODE_MASK = 0b00110000;
+    static const uint8_t REPORT_DISP_MODE_POS  = 4;
+    static const uint8_t REPORT_DISP_MODE_AUTO     = 0;
+    static const uint8_t REPORT_DISP_MODE_SET      = 1;
+    static const uint8_t REPORT_DISP_MODE_ACT      = 2;
+    static const uint8_t REPORT_DISP_MODE_OUT      = 3;
+
+    static const uint8_t REPORT_DISP_F_BYTE    = 7;
+    static const uint8_t REPORT_DISP_F_MASK    = 0b10000000;
+
+    static const uint8_t REPORT_IONIZER1_BYTE    = 6;
+    static const uint8_t REPORT_IONIZER1_MASK    = 0b00000100;
+    static const uint8_t REPORT_IONIZER2_BYTE    = 0;
+    static const uint8_t REPORT_IONIZER2_MASK    = 0b00000100;
+
+    static const uint8_t REPORT_SLEEP_BYTE       = 4;
+    static const uint8_t REPORT_SLEEP_MASK       = 0b00001000;
+
+    static const uint8_t REPORT_XFAN_BYTE        = 6;
+    static const uint8_t REPORT_XFAN_MASK        = 0b00001000;
+
+    static const uint8_t REPORT_POWERSAVE_BYTE   = 11;
+    static const uint8_t REPORT_POWERSAVE_MASK   = 0b01000000;
+
+    static const uint8_t REPORT_IFEEL_BYTE       = 9;
+    static const uint8_t REPORT_IFEEL_MASK       = 0b01000000;
+
+    static const uint8_t REPORT_BEEPER_BYTE    = 40;
+    static const uint8_t REPORT_BEEPER_MASK    = 0b00000001;
+
+    static const uint8_t MAC_REPORT_PAYLOAD_LEN = 11;
+
+    /* SET packet shares all the byte definition with REPORT */
+    static const uint8_t SET_PACKET_LEN        = 45;
+    
+    static const uint8_t SET_CONST_02_BYTE     = 39;
+    static const uint8_t SET_CONST_02_VAL      = 0x02;
+
+    static const uint8_t SET_AF_BYTE           = 3;
+    static const uint8_t SET_AF_VAL            = 0xAF;
+
+    static const uint8_t SET_NOCHANGE_BYTE     = 11;
+    static const uint8_t SET_NOCHANGE_MASK     = 0b00001000;
+
+    static const uint8_t SET_CONST_BIT_BYTE    = 7;
+    static const uint8_t SET_CONST_BIT_MASK    = 0b00000010;
+
+    /* time constraints */
+    static const unsigned long TIME_REFRESH_PERIOD_MS   =  330;
+    static const unsigned long TIME_MAC_CYCLE_PERIOD_MS = 60000;
+    static const unsigned long TIME_TIMEOUT_INACTIVE_MS = 10000;
+    static const unsigned long TIME_WAIT_RESPONSE_TIMEOUT_MS = 10000;
+    static const unsigned long TIME_CONFIRM_TIMEOUT_MS = 10000;  /* a command not confirmed by then is given up */
+}
+
+}  // namespace CNT
+
+/* a whole frame built at compile time, checksum included: 7E 7E len cmd payload checksum */
+template<size_t N> struct ConstFrame {
+    uint8_t data[N + 5];
+
+    constexpr ConstFrame(uint8_t cmd, const uint8_t (&payload)[N]) : data{}
+    {
+        this->data[0] = CNT::protocol::SYNC;
+        this->data[1] = CNT::protocol::SYNC;
+        this->data[2] = N + 2;
+        this->data[3] = cmd;
+        for (size_t i = 0; i < N; i++)
+            this->data[4 + i] = payload[i];
+        this->data[N + 4] = frame_checksum(this->data, N + 5);
+    }
+};
+
+}  // namespace gree_ac
+}  // namespace esphome
@@ -0,0 +1,332 @@
+#include "gree_ac_recorder.h"
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace gree_ac {
+
+static const char *const TAG = "gree_ac.recorder";
+
+static const uint8_t DUMP_CHUNK = 32;  // bytes per log line
+
+size_t format_hex_dotted(char *out, size_t out_size, const uint8_t *data, size_t len, char separator)
+{
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    size_t pos = 0;
+
+    if (out_size == 0)
+        return 0;
+
+    for (size_t i = 0; i < len; i++) {
+        bool separate = i > 0 && separator != '\0';
+        size_t needed = (separate ? 3 : 2) + 1;  // [separator] + two digits + terminator
+        if (pos + needed > out_size)
+            break;
+        if (separate)
+            out[pos++] = separator;
+        out[pos++] = HEX_DIGITS[data[i] >> 4];
+        out[pos++] = HEX_DIGITS[data[i] & 0x0F];
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+static void log_frame(uint32_t time, bool outgoing, const uint8_t *data, size_t len)
+{
+    char line[DUMP_CHUNK * 3];
+
+    for (size_t start = 0; start < len; start += DUMP_CHUNK) {
+        size_t chunk = len - start < DUMP_CHUNK ? len - start : DUMP_CHUNK;
+        format_hex_dotted(line, sizeof(line), &data[start], chunk);
+        if (start == 0) {
+            ESP_LOGI(TAG, "%10u %s : %s", (unsigned) time, outgoing ? "TX" : "RX", line);
+        } else {
+            ESP_LOGI(TAG, "%10s    : %s", "", line);
+        }
+    }
+}
+
+void FlightRecorder::init(size_t capacity)
+{
+    if (capacity == 0 || this->buf_ != nullptr)
+        return;
+
+    /* the only allocation, recording itself never touches the heap */
+    this->buf_ = new uint8_t[capacity];
+    this->capacity_ = capacity;
+}
+
+void FlightRecorder::put_(uint8_t value)
+{
+    this->buf_[this->head_] = value;
+    this->head_ = (this->head_ + 1) % this->capacity_;
+    this->used_++;
+}
+
+size_t FlightRecorder::record_len_at_(size_t offset) const
+{
+    if (this->at_(offset) & REC_DELTA)
+        return DELTA_HEADER_LEN + 2 * this->at_(offset + 4);
+    return FULL_HEADER_LEN + this->at_(offset + 5);
+}
+
+void FlightRecorder::make_room_(size_t len)
+{
+    while (this->capacity_ - this->used_ < len) {
+        size_t oldest = this->record_len_at_(0);
+        this->tail_ = (this->tail_ + oldest) % this->capacity_;
+        this->used_ -= oldest;
+        this->records_--;
+    }
+}
+
+FlightRecorder::BaseFrame *FlightRecorder::find_base_(BaseFrame *slots, uint8_t count, bool outgoing, uint8_t cmd)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        if (slots[i].used && slots[i].outgoing == outgoing && slots[i].cmd == cmd)
+            return &slots[i];
+    }
+    return nullptr;
+}
+
+FlightRecorder::BaseFrame *FlightRecorder::evict_base_(BaseFrame *slots, uint8_t count)
+{
+    BaseFrame *oldest = &slots[0];
+    for (uint8_t i = 0; i < count; i++) {
+        if (!slots[i].used)
+            return &slots[i];
+        if (slots[i].last_use < oldest->last_use)
+            oldest = &slots[i];
+    }
+    return oldest;
+}
+
+void FlightRecorder::record(const uint8_t *data, size_t len, bool outgoing, uint32_t now)
+{
+    if (this->buf_ == nullptr || len == 0 || len > 0xFF)
+        return;
+
+    uint8_t cmd = len > 3 ? data[3] : 0;
+    uint32_t elapsed = now - this->last_time_;
+    BaseFrame *base = this->find_base_(this->bases_, BASE_SLOTS, outgoing, cmd);
+
+    /* delta against the previous frame of the same kind, as long as only a few bytes changed */
+    uint8_t diffs = 0;
+    bool delta = base != nullptr && base->len == len && base->deltas < KEYFRAME_INTERVAL && elapsed <= 0xFFFF;
+    for (size_t i = 0; delta && i < len; i++) {
+        if (base->data[i] != data[i] && ++diffs > len / 4)
+            delta = false;
+    }
+
+    size_t rec_len = delta ? DELTA_HEADER_LEN + 2 * diffs : FULL_HEADER_LEN + len;
+    if (rec_len > this->capacity_)
+        return;
+    this->make_room_(rec_len);
+
+    uint8_t hdr = outgoing ? REC_TX : 0;
+    if (delta) {
+        this->put_(hdr | REC_DELTA);
+        this->put_(elapsed & 0xFF);
+        this->put_(elapsed >> 8);
+        this->put_(cmd);
+        this->put_(diffs);
+        for (size_t i = 0; i < len; i++) {
+            if (base->data[i] != data[i]) {
+                this->put_(i);
+                this->put_(data[i]);
+                base->data[i] = data[i];
+            }
+        }
+        base->deltas++;
+    } else {
+        this->put_(hdr);
+        for (uint8_t shift = 0; shift < 32; shift += 8)
+            this->put_((now >> shift) & 0xFF);
+        this->put_(len);
+        for (size_t i = 0; i < len; i++)
+            this->put_(data[i]);
+
+        if (base == nullptr)
+            base = this->evict_base_(this->bases_, BASE_SLOTS);
+        base->used = len <= FRAME_MAX;
+        base->outgoing = outgoing;
+        base->cmd = cmd;
+        base->len = len;
+        base->deltas = 0;
+        if (base->used)
+            memcpy(base->data, data, len);
+    }
+
+    base->last_use = ++this->uses_;
+    this->last_time_ = now;
+    this->records_++;
+}
+
+void FlightRecorder::dump()
+{
+    if (this->buf_ == nullptr) {
+        ESP_LOGW(TAG, "Flight recorder is disabled");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Flight recorder: %u records, %u of %u bytes used",
+             (unsigned) this->records_, (unsigned) this->used_, (unsigned) this->capacity_);
+
+    BaseFrame slots[DUMP_SLOTS] = {};
+    uint8_t frame[0xFF];
+    uint32_t time = 0;
+    uint32_t uses = 0;
+    uint32_t skipped = 0;
+
+    for (size_t offset = 0; offset < this->used_; offset += this->record_len_at_(offset)) {
+        uint8_t hdr = this->at_(offset);
+        bool outgoing = (hdr & REC_TX) != 0;
+
+        if (hdr & REC_DELTA) {
+            time += this->at_(offset + 1) | (this->at_(offset + 2) << 8);
+            uint8_t cmd = this->at_(offset + 3);
+            uint8_t diffs = this->at_(offset + 4);
+
+            /* the full frame this delta is based on was already overwritten */
+            BaseFrame *base = this->find_base_(slots, DUMP_SLOTS, outgoing, cmd);
+            if (base == nullptr) {
+                skipped++;
+                continue;
+            }
+
+            for (uint8_t i = 0; i < diffs; i++) {
+                uint8_t index = this->at_(offset + DELTA_HEADER_LEN + 2 * i);
+                if (index < base->len)
+                    base->data[index] = this->at_(offset + DELTA_HEADER_LEN + 2 * i + 1);
+            }
+            base->last_use = ++uses;
+            log_frame(time, outgoing, base->data, base->len);
+        } else {
+            time = 0;
+            for (uint8_t i = 0; i < 4; i++)
+                time |= (uint32_t) this->at_(offset + 1 + i) << (8 * i);
+            uint8_t len = this->at_(offset + 5);
+            for (uint8_t i = 0; i < len; i++)
+                frame[i] = this->at_(offset + FULL_HEADER_LEN + i);
+
+            uint8_t cmd = len > 3 ? frame[3] : 0;
+            BaseFrame *base = this->find_base_(slots, DUMP_SLOTS, outgoing, cmd);
+            if (base == nullptr)
+                base = this->evict_base_(slots, DUMP_SLOTS);
+            base->used = len <= FRAME_MAX;
+            base->outgoing = outgoing;
+            base->cmd = cmd;
+            base->len = len;
+            base->last_use = ++uses;
+            if (base->used)
+                memcpy(base->data, frame, len);
+
+            log_frame(time, outgoing, frame, len);
+        }
+    }
+
+    if (skipped > 0) {
+        ESP_LOGI(TAG, "%u oldest records could not be restored", (unsigned) skipped);
+    }
+}
+
+/*
+ * Packet log queue
+ */
+
+void PacketLogQueue::put_(uint8_t value)
+{
+    this->buf_[this->head_] = value;
+    this->head_ = (this->head_ + 1) % SIZE;
+    this->used_++;
+}
+
+uint8_t PacketLogQueue::get_()
+{
+    uint8_t value = this->buf_[this->tail_];
+    this->tail_ = (this->tail_ + 1) % SIZE;
+    this->used_--;
+    return value;
+}
+
+bool PacketLogQueue::push(const uint8_t *data, size_t len, uint8_t flags, uint32_t time)
+{
+    if (len > 0xFF || SIZE - this->used_ < len + HEADER_LEN) {
+        this->dropped_++;
+        return false;
+    }
+
+    this->put_(flags);
+    for (uint8_t shift = 0; shift < 32; shift += 8)
+        this->put_((time >> shift) & 0xFF);
+    this->put_(len);
+    for (size_t i = 0; i < len; i++)
+        this->put_(data[i]);
+    return true;
+}
+
+size_t PacketLogQueue::pop(uint8_t *data, size_t max_len, uint8_t *flags, uint32_t *time)
+{
+    if (this->used_ == 0)
+        return 0;
+
+    *flags = this->get_();
+    *time = 0;
+    for (uint8_t shift = 0; shift < 32; shift += 8)
+        *time |= (uint32_t) this->get_() << shift;
+    size_t len = this->get_();
+    for (size_t i = 0; i < len; i++) {
+        uint8_t value = this->get_();
+        if (i < max_len)
+            data[i] = value;
+    }
+    return len < max_len ? len : max_len;
+}
+
+uint32_t PacketLogQueue::take_dropped()
+{
+    uint32_t dropped = this->dropped_;
+    this->dropped_ = 0;
+    return dropped;
+}
+
+/*
+ * Trace ring
+ */
+
+static const char *const TRACE_TAG = "gree_ac.trace";
+
+static const char TRACE_POINT_NAMES[TRACE_POINT_COUNT][14] PROGMEM = {
+    "rx_first_byte", "rx_frame", "verify", "decode", "publish", "control", "af_build", "tx"
+};
+
+void TraceRing::init(size_t entries)
+{
+    if (entries == 0 || this->events_ != nullptr)
+        return;
+
+    this->events_ = new Event[entries];
+    this->capacity_ = entries;
+}
+
+void TraceRing::dump()
+{
+    if (this->events_ == nullptr) {
+        ESP_LOGW(TRACE_TAG, "Tracing is disabled");
+        return;
+    }
+
+    ESP_LOGI(TRACE_TAG, "Trace: %u of %u events", (unsigned) this->count_, (unsigned) this->capacity_);
+    size_t first = (this->head_ + this->capacity_ - this->count_) % this->capacity_;
+    for (size_t i = 0; i < this->count_; i++) {
+        const Event &event = this->events_[(first + i) % this->capacity_];
+        ESP_LOGI(TRACE_TAG, "TRACE %u %s %u", (unsigned) event.time_us, TRACE_POINT_NAMES[event.point],
+                 (unsigned) event.arg);
+    }
+}
+
+}  // namespace gree_ac
+}  // namespace esphome
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace gree_ac {
+
+/*
+ * formats data as "7E.7E.2F..." into out without touching the heap, returns the number of chars written
+ * separator '\0' writes the digits back to back ("7E7E2F...")
+ */
+size_t format_hex_dotted(char *out, size_t out_size, const uint8_t *data, size_t len, char separator = '.');
+
+/*
+ * Always-on RAM flight recorder for the last frames on the bus.
+ *
+ * Records are packed back to back in a byte ring:
+ *   full  : [hdr][timestamp ms, u32 LE][len][len bytes]
+ *   delta : [hdr][ms since previous record, u16 LE][cmd][n][n x (index, value)]
+ * hdr bit 0 is the direction (1 = TX), bit 1 marks a delta record.
+ * A delta record lists the bytes which differ from the previous frame with the same direction and command,
+ * so the unchanged unit reports and set frames cost a few bytes each.
+ */
+class FlightRecorder {
+    public:
+        void init(size_t capacity);
+        bool is_enabled() const { return this->buf_ != nullptr; }
+
+        void record(const uint8_t *data, size_t len, bool outgoing, uint32_t now);
+        void dump();
+
+    protected:
+        static const uint8_t REC_TX = 0x01;
+        static const uint8_t REC_DELTA = 0x02;
+        static const uint8_t FULL_HEADER_LEN = 6;
+        static const uint8_t DELTA_HEADER_LEN = 5;
+        static const uint8_t FRAME_MAX = 64;          // longer frames are always stored in full
+        static const uint8_t KEYFRAME_INTERVAL = 32;  // force a full record after this many deltas
+        static const uint8_t BASE_SLOTS = 4;
+        static const uint8_t DUMP_SLOTS = 8;
+
+        struct BaseFrame {
+            bool used;
+            bool outgoing;
+            uint8_t cmd;
+            uint8_t len;
+            uint8_t deltas;
+            uint32_t last_use;
+            uint8_t data[FRAME_MAX];
+        };
+
+        uint8_t at_(size_t offset) const { return this->buf_[(this->tail_ + offset) % this->capacity_]; }
+        void put_(uint8_t value);
+        void make_room_(size_t len);
+        size_t record_len_at_(size_t offset) const;
+        BaseFrame *find_base_(BaseFrame *slots, uint8_t count, bool outgoing, uint8_t cmd);
+        BaseFrame *evict_base_(BaseFrame *slots, uint8_t count);
+
+        uint8_t *buf_ = nullptr;
+        size_t capacity_ = 0;
+        size_t head_ = 0;       // next write position
+        size_t tail_ = 0;       // oldest record
+        size_t used_ = 0;
+        uint32_t records_ = 0;
+        uint32_t last_time_ = 0;
+        uint32_t uses_ = 0;
+        BaseFrame bases_[BASE_SLOTS] = {};
+};
+
+/*
+ * Fixed size queue of raw frames waiting to be dumped to the log.
+ * Records are [flags][timestamp ms, u32 LE][len][len bytes]; when the queue is full new frames are dropped and counted.
+ */
+class PacketLogQueue {
+    public:
+        static const uint8_t FLAG_TX = 0x01;
+        static const uint8_t FLAG_TX_ENABLED = 0x02;
+
+        bool push(const uint8_t *data, size_t len, uint8_t flags, uint32_t time);
+        size_t pop(uint8_t *data, size_t max_len, uint8_t *flags, uint32_t *time);
+        uint32_t take_dropped();
+
+    protected:
+        static const size_t SIZE = 256;
+        static const uint8_t HEADER_LEN = 6;
+
+        void put_(uint8_t value);
+        uint8_t get_();
+
+        uint8_t buf_[SIZE];
+        size_t head_ = 0;
+        size_t tail_ = 0;
+        size_t used_ = 0;
+        uint32_t dropped_ = 0;
+};
+
+/* trace points of the RX -> decode -> publish and control -> TX paths */
+typedef enum {
+        TRACE_RX_FIRST_BYTE,
+        TRACE_RX_FRAME,        // arg: frame length
+        TRACE_VERIFY,          // arg: 1 = valid
+        TRACE_DECODE,          // arg: command
+        TRACE_PUBLISH,         // arg: PublishEntity_t
+        TRACE_CONTROL,         // arg: 0 = control(), 1 = apply_scene()
+        TRACE_AF_BUILD,
+        TRACE_TX,              // arg: command
+        TRACE_POINT_COUNT
+} TracePoint_t;
+
+/*
+ * Fixed ring of timestamped trace points, the oldest are overwritten.
+ * dump() logs one "TRACE <us> <point> <arg>" line per event, sniffer/trace2chrome.py turns that into a Chrome trace.
+ */
+class TraceRing {
+    public:
+        void init(size_t entries);
+        bool is_enabled() const { return this->events_ != nullptr; }
+
+        void record(TracePoint_t point, uint8_t arg, uint32_t time_us) {
+            if (this->events_ == nullptr)
+                return;
+            Event &event = this->events_[this->head_];
+            event.time_us = time_us;
+            event.point = point;
+            event.arg = arg;
+            this->head_ = (this->head_ + 1) % this->capacity_;
+            if (this->count_ < this->capacity_)
+                this->count_++;
+        }
+        void dump();
+
+    protected:
+        struct Event {
+            uint32_t time_us;
+            uint8_t point;
+            uint8_t arg;
+        };
+
+        Event *events_ = nullptr;
+        size_t capacity_ = 0;
+        size_t head_ = 0;
+        size_t count_ = 0;
+};
+
+}  // namespace gree_ac
+}  // namespace esphome
@@ -0,0 +1,90 @@
+/*
+ * The component built with every entity excluded, against the simulated unit. Swing, quiet and turbo have
+ * no entity then, but the climate swing mode and the fan / turbo / quiet interlocks still need them:
+ *
+ *   - a climate swing call reaches the unit and comes back as the climate swing mode,
+ *   - quiet from a scene reaches the unit and comes back,
+ *   - a fan change clears quiet in the unit, not only in the component,
+ *   - the state snapshot leaves out the keys of the fields which are not decoded.
+ */
+#include <cstdio>
+#include <string>
+
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+#include "harness/rig.h"
+#include "harness/unit_model.h"
+
+using namespace gree_ac_host;
+using namespace esphome;
+using namespace esphome::gree_ac;
+
+/* a report cycle plus the unit's latency, with room to spare */
+static const uint32_t SETTLE_MS = 3000;
+
+static int failures = 0;
+
+static void expect(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+    if (!ok)
+        failures++;
+}
+
+int main()
+{
+    host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+
+    Rig rig;
+    SimulatedUnit unit(rig);
+    rig.on_tx = [&](const TxFrame &frame) { unit.on_frame(frame); };
+    std::string snapshot;
+    rig.snapshot().add_on_state_callback([&](const std::string &state) { snapshot = state; });
+    rig.setup();
+
+    auto settle = [&]() {
+        uint32_t end = millis() + SETTLE_MS;
+        while ((int32_t) (millis() - end) < 0) {
+            unit.poll();
+            rig.step();
+        }
+    };
+
+    settle();
+    expect(rig.ac().ready(), "talking to the unit");
+
+    rig.ac().make_call().set_swing_mode(climate::CLIMATE_SWING_VERTICAL).perform();
+    settle();
+    expect(unit.field(CNT::protocol::REPORT_VSWING_BYTE, CNT::protocol::REPORT_VSWING_MASK) ==
+               CNT::protocol::REPORT_VSWING_FULL << CNT::protocol::REPORT_VSWING_POS,
+           "climate swing mode sent to the unit");
+    expect(rig.ac().swing_mode == climate::CLIMATE_SWING_VERTICAL, "climate swing mode reported back");
+
+    CNT::SceneParams scene;
+    scene.quiet = std::string("On");
+    rig.ac().apply_scene(scene);
+    settle();
+    expect(unit.field(CNT::protocol::REPORT_FAN_QUIET_BYTE, CNT::protocol::REPORT_FAN_QUIET_MASK) != 0,
+           "quiet from a scene sent to the unit");
+    expect(rig.ac().quiet() == quiet_options::ON, "quiet reported back");
+
+    rig.ac().make_call().set_fan_mode(climate::CLIMATE_FAN_HIGH).perform();
+    settle();
+    expect(unit.field(CNT::protocol::REPORT_FAN_QUIET_BYTE, CNT::protocol::REPORT_FAN_QUIET_MASK) == 0,
+           "fan change clears quiet in the unit");
+    expect(rig.ac().quiet() == quiet_options::OFF, "quiet off reported back");
+    expect(rig.ac().swing_mode == climate::CLIMATE_SWING_VERTICAL, "swing kept over the fan change");
+
+    printf("snapshot %s\n", snapshot.c_str());
+    bool decoded_keys = true;
+    for (const char *key : {"\"vs\":", "\"hs\":", "\"l\":", "\"q\":", "\"tb\":"})
+        decoded_keys &= snapshot.find(key) != std::string::npos;
+    bool excluded_keys = false;
+    for (const char *key : {"\"d\":", "\"u\":", "\"io\":", "\"bp\":", "\"sl\":", "\"xf\":", "\"ps\":", "\"if\":"})
+        excluded_keys |= snapshot.find(key) != std::string::npos;
+    expect(decoded_keys, "snapshot has the decoded fields");
+    expect(!excluded_keys, "snapshot leaves out the fields of excluded entities");
+
+    printf("%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
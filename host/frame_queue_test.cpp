@@ -0,0 +1,104 @@
+/*
+ * FrameQueue between two std::threads, the way the RX task and the main loop use it: one producer, one
+ * consumer, no lock. Every frame carries its sequence number and a pattern derived from it, so a torn or
+ * reordered slot shows up in the consumer.
+ *
+ *   lossless: the producer retries a full queue, every frame has to arrive, in order
+ *   dropping: the producer gives up on a full queue like the RX task, the frames which arrive are in order
+ *             and, with the dropped ones, add up to all frames; dropped() counts exactly the failed pushes
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "gree_ac_protocol.h"
+
+using esphome::gree_ac::FrameQueue;
+using esphome::gree_ac::QueuedFrame_t;
+
+static const uint32_t FRAMES = 200000;
+
+static uint8_t frame_size(uint32_t seq) { return 5 + seq % 60; }
+
+static void fill(uint8_t *data, uint32_t seq)
+{
+    memcpy(data, &seq, sizeof(seq));
+    for (uint8_t i = sizeof(seq); i < frame_size(seq); i++)
+        data[i] = (uint8_t) (seq * 31 + i);
+}
+
+static bool check(const QueuedFrame_t &frame, uint32_t seq)
+{
+    uint8_t expected[esphome::gree_ac::FRAME_DATA_MAX];
+    fill(expected, seq);
+    return frame.size == frame_size(seq) && memcmp(frame.data, expected, frame.size) == 0 &&
+           frame.time_ms == seq && frame.time_us == seq * 2 && frame.first_us == seq * 3 &&
+           frame.discarded == seq % 7 && frame.checksum_ok == (seq % 3 == 0);
+}
+
+static bool run(bool retry)
+{
+    FrameQueue *queue = new FrameQueue();
+    std::atomic<bool> done{false};
+    uint32_t failed_pushes = 0;
+
+    std::thread producer([&]() {
+        uint8_t data[esphome::gree_ac::FRAME_DATA_MAX];
+        for (uint32_t seq = 0; seq < FRAMES; seq++) {
+            fill(data, seq);
+            while (!queue->push(data, frame_size(seq), seq % 3 == 0, seq % 7, seq, seq * 2, seq * 3)) {
+                failed_pushes++;
+                if (!retry)
+                    break;
+                std::this_thread::yield();
+            }
+            if (seq % 16 == 0)
+                std::this_thread::yield();  // the RX task sleeps between polls as well
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint32_t received = 0;
+    int64_t last_seq = -1;
+    bool ok = true;
+    for (;;) {
+        const QueuedFrame_t *frame = queue->front();
+        if (frame == nullptr) {
+            if (done.load(std::memory_order_acquire) && queue->front() == nullptr)
+                break;
+            std::this_thread::yield();  // one core here: let the producer run
+            continue;
+        }
+        uint32_t seq;
+        memcpy(&seq, frame->data, sizeof(seq));
+        if ((int64_t) seq <= last_seq || (retry && seq != last_seq + 1) || !check(*frame, seq)) {
+            fprintf(stderr, "%s: bad frame %u after %lld\n", retry ? "lossless" : "dropping", (unsigned) seq,
+                    (long long) last_seq);
+            ok = false;
+            break;
+        }
+        last_seq = seq;
+        received++;
+        queue->pop();
+    }
+    producer.join();
+
+    uint32_t lost = retry ? 0 : failed_pushes;
+    if (ok && (received + lost != FRAMES || queue->dropped() != failed_pushes)) {
+        fprintf(stderr, "%s: %u received, %u lost, %u dropped counted, %u failed pushes\n", retry ? "lossless" : "dropping",
+                (unsigned) received, (unsigned) lost, (unsigned) queue->dropped(), (unsigned) failed_pushes);
+        ok = false;
+    }
+    printf("%s: %u frames received, %u pushes found the queue full\n", retry ? "lossless" : "dropping",
+           (unsigned) received, (unsigned) failed_pushes);
+    delete queue;
+    return ok;
+}
+
+int main()
+{
+    bool ok = run(true);
+    ok &= run(false);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+/*
+ * gree_fuzz: fuzz target for the frame synchronizer and the packet handlers.
+ *
+ * Every input is injected into a freshly set up component as bytes from the unit, so it goes through
+ * serial_process_feed() in GreeAC::loop() and, for every frame that comes out, verify_packet() and
+ * handle_packet(). A synchronizer of its own checks the framing invariants on the same bytes, and the
+ * component has to see exactly the frames the synchronizer cut.
+ *
+ * With clang and -DGREE_AC_LIBFUZZER=ON this is a libFuzzer target. Otherwise gree_fuzz has its own main():
+ *
+ *   gree_fuzz FILE|DIR...                       run the inputs once, e.g. a crash found by libFuzzer
+ *   gree_fuzz [--iterations N] [--seed S]      mutate the sample frames (bit flips, dropped and doubled bytes,
+ *                                              0x7E in lengths and payloads, truncation, garbage bursts)
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+#include "harness/rig.h"
+
+using namespace gree_ac_host;
+using namespace esphome::gree_ac;
+
+static uint64_t total_frames = 0;
+static uint64_t total_accepted = 0;
+
+static void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+    fprintf(stderr, "invariant violated: %s\n", what);
+    abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    esphome::host::set_log_level(ESPHOME_LOG_LEVEL_NONE);
+    esphome::host::use_simulated_time();
+
+    SerialProcess_t sp;
+    serial_process_reset(&sp);
+    uint32_t frames = 0;
+    for (size_t i = 0; i < size; i++) {
+        bool complete = serial_process_feed(&sp, data[i]);
+        check(sp.size <= FRAME_DATA_MAX, "size within the buffer");
+        if (!complete)
+            continue;
+        check(sp.size >= 3 && sp.size == (size_t) sp.frame_size + 3, "complete frame has its announced length");
+        check(sp.data[0] == 0x7E && sp.data[1] == 0x7E, "complete frame starts with the sync bytes");
+        frames++;
+        serial_process_reset(&sp);
+    }
+
+    Rig rig;
+    rig.setup();
+    rig.send_from_unit(data, size, false);
+    for (uint32_t pass = 0; pass < 4 || (rig.unit_bytes_pending() && pass < 100000); pass++)
+        rig.step();
+    check(!rig.unit_bytes_pending(), "all bytes read");
+
+    uint32_t handled = rig.ac().rx_frames() + rig.ac().rx_errors();
+    check(handled == frames, "component handled every frame the synchronizer cut");
+    total_frames += frames;
+    total_accepted += rig.ac().rx_frames();
+    return 0;
+}
+
+#ifndef GREE_AC_LIBFUZZER
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+static std::vector<uint8_t> with_checksum(std::vector<uint8_t> frame)
+{
+    frame.push_back(0);
+    frame.back() = frame_checksum(frame.data(), frame.size());
+    return frame;
+}
+
+/* the frames the unit sends, see documents/protocol.txt */
+static std::vector<std::vector<uint8_t>> sample_frames()
+{
+    std::vector<uint8_t> report = {0x7E, 0x7E, 0x2F, 0x31, 0x04, 0x00, 0x40, 0x00, 0xC0, 0x80, 0x0C, 0x02, 0x00};
+    report.resize(4 + 45, 0x00);
+    report[4 + 18] = 0x08;
+    report[4 + 42] = 0x3E;
+
+    std::vector<uint8_t> model_id = {0x7E, 0x7E, 0x1A, 0x44, 0x01, 0x00, 0x01};
+    model_id.resize(4 + 22, 0x00);
+    model_id.push_back(0x01);
+
+    std::vector<uint8_t> unknown = {0x7E, 0x7E, 0x2F, 0x33, 0x00, 0x00, 0x40, 0x00, 0x09, 0x20, 0x19, 0x0A, 0x00, 0x10,
+                                    0x00, 0x14, 0x17, 0x5B, 0x08, 0x08};
+    unknown.resize(4 + 45, 0x00);
+
+    return {with_checksum(report), with_checksum(model_id), with_checksum(unknown)};
+}
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng()
+{
+    /* xorshift32, so a seed gives the same run everywhere */
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void mutate(std::vector<uint8_t> &input)
+{
+    if (input.empty())
+        return;
+    size_t pos = rng() % input.size();
+    switch (rng() % 8) {
+        case 0:  // bit flip
+            input[pos] ^= 1 << (rng() % 8);
+            break;
+        case 1:  // dropped byte
+            input.erase(input.begin() + pos);
+            break;
+        case 2:  // doubled byte
+            input.insert(input.begin() + pos, input[pos]);
+            break;
+        case 3:  // sync bytes inside a frame
+            input.insert(input.begin() + pos, {0x7E, 0x7E});
+            break;
+        case 4:  // 0x7E as a length or payload byte
+            input[pos] = 0x7E;
+            break;
+        case 5:  // truncated
+            input.resize(pos);
+            break;
+        case 6:  // garbage burst
+            for (uint32_t n = 1 + rng() % 32; n > 0; n--)
+                input.insert(input.begin() + pos, (uint8_t) rng());
+            break;
+        case 7:  // any other byte
+            input[pos] = (uint8_t) rng();
+            break;
+    }
+}
+
+static bool run_file(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t len;
+    while ((len = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + len);
+    fclose(file);
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+    return true;
+}
+
+static bool run_path(const std::string &path, uint32_t *inputs)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        fprintf(stderr, "%s: not found\n", path.c_str());
+        return false;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        (*inputs)++;
+        return run_file(path);
+    }
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return false;
+    bool ok = true;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.')
+            continue;
+        ok &= run_path(path + "/" + entry->d_name, inputs);
+    }
+    closedir(dir);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 10000;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = (uint32_t) strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rng_state = (uint32_t) strtoul(argv[++i], nullptr, 0);
+            if (rng_state == 0)
+                rng_state = 1;
+        } else if (argv[i][0] != '-') {
+            paths.push_back(argv[i]);
+        } else {
+            fprintf(stderr, "usage: gree_fuzz FILE|DIR... | gree_fuzz [--iterations N] [--seed S]\n");
+            return 2;
+        }
+    }
+
+    uint32_t inputs = 0;
+    if (!paths.empty()) {
+        bool ok = true;
+        for (const std::string &path : paths)
+            ok &= run_path(path, &inputs);
+        if (!ok)
+            return 1;
+    } else {
+        std::vector<std::vector<uint8_t>> samples = sample_frames();
+        for (; inputs < iterations; inputs++) {
+            std::vector<uint8_t> input;
+            for (uint32_t n = 1 + rng() % 3; n > 0; n--) {
+                const std::vector<uint8_t> &frame = samples[rng() % samples.size()];
+                input.insert(input.end(), frame.begin(), frame.end());
+            }
+            for (uint32_t n = rng() % 5; n > 0; n--)
+                mutate(input);
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+    }
+
+    printf("%u inputs: %llu frames cut, %llu accepted, no invariant violated\n", (unsigned) inputs,
+           (unsigned long long) total_frames, (unsigned long long) total_accepted);
+    return 0;
+}
+
+#endif  // GREE_AC_LIBFUZZER
@@ -0,0 +1,79 @@
+#include "gcap.h"
+
+#include <cstring>
+
+namespace gree_ac_host {
+
+static const char MAGIC[4] = {'G', 'C', 'A', 'P'};
+static const uint8_t VERSION = 1;
+static const size_t FILE_HEADER_LEN = 8;
+static const size_t RECORD_HEADER_LEN = 6;
+
+bool read_gcap(const std::string &path, std::vector<GcapRecord> *records, std::string *error)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        *error = path + ": cannot open";
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t len;
+    while ((len = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + len);
+    fclose(file);
+
+    if (data.size() < FILE_HEADER_LEN || memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0 || data[4] != VERSION) {
+        *error = path + ": not a GCAP v1 file";
+        return false;
+    }
+
+    size_t offset = FILE_HEADER_LEN;
+    while (offset + RECORD_HEADER_LEN <= data.size()) {
+        GcapRecord record;
+        record.time_ms = data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((uint32_t) data[offset + 3] << 24);
+        record.direction = data[offset + 4];
+        size_t frame_len = data[offset + 5];
+        offset += RECORD_HEADER_LEN;
+        if (offset + frame_len > data.size()) {
+            fprintf(stderr, "%s: last record is truncated\n", path.c_str());
+            break;
+        }
+        record.frame.assign(data.begin() + offset, data.begin() + offset + frame_len);
+        records->push_back(std::move(record));
+        offset += frame_len;
+    }
+    return true;
+}
+
+bool GcapWriter::open(const std::string &path)
+{
+    this->file_ = fopen(path.c_str(), "wb");
+    if (this->file_ == nullptr)
+        return false;
+    uint8_t header[FILE_HEADER_LEN] = {'G', 'C', 'A', 'P', VERSION, 0, 0, 0};
+    fwrite(header, 1, sizeof(header), this->file_);
+    return true;
+}
+
+void GcapWriter::write(uint32_t time_ms, uint8_t direction, const uint8_t *frame, size_t len)
+{
+    if (this->file_ == nullptr)
+        return;
+    uint8_t header[RECORD_HEADER_LEN] = {
+        (uint8_t) time_ms, (uint8_t) (time_ms >> 8), (uint8_t) (time_ms >> 16), (uint8_t) (time_ms >> 24),
+        direction, (uint8_t) len,
+    };
+    fwrite(header, 1, sizeof(header), this->file_);
+    fwrite(frame, 1, len, this->file_);
+}
+
+void GcapWriter::close()
+{
+    if (this->file_ != nullptr) {
+        fclose(this->file_);
+        this->file_ = nullptr;
+    }
+}
+
+}  // namespace gree_ac_host
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* GCAP captures, see documents/capture-format.txt and sniffer/gcap.py */
+
+namespace gree_ac_host {
+
+static const uint8_t GCAP_FROM_UNIT = 0;
+static const uint8_t GCAP_TO_UNIT = 1;
+
+struct GcapRecord {
+    uint32_t time_ms;
+    uint8_t direction;
+    std::vector<uint8_t> frame;
+};
+
+/* false with a message in error if the file cannot be read or is not a GCAP v1 capture */
+bool read_gcap(const std::string &path, std::vector<GcapRecord> *records, std::string *error);
+
+class GcapWriter {
+    public:
+        ~GcapWriter() { this->close(); }
+
+        bool open(const std::string &path);
+        void write(uint32_t time_ms, uint8_t direction, const uint8_t *frame, size_t len);
+        void close();
+
+    protected:
+        FILE *file_ = nullptr;
+};
+
+}  // namespace gree_ac_host
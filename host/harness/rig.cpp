@@ -0,0 +1,195 @@
+#include "rig.h"
+
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/host.h"
+
+#include <cstdio>
+
+namespace gree_ac_host {
+
+using namespace esphome::gree_ac;
+
+template<size_t N> static std::vector<std::string> option_names(const OptionDef (&options)[N])
+{
+    std::vector<std::string> names;
+    for (size_t i = 0; i < N; i++)
+        names.push_back(options[i].name);
+    return names;
+}
+
+Rig::Rig(bool simulated_time) : simulated_(simulated_time), ac_(new HostGreeAC())
+{
+    if (simulated_time && !host::simulated_time())
+        host::use_simulated_time();
+
+    this->ac_->set_uart_parent(&this->uart_);
+    this->uart_.set_tx_callback([this](const uint8_t *data, size_t len) { this->on_write_(data, len); });
+    serial_process_reset(&this->tx_framer_);
+
+    auto add_select = [this](const char *name, std::vector<std::string> options) {
+        auto *select = new GreeACSelect();
+        select->traits.set_options(std::move(options));
+        this->selects_.emplace_back(name, select);
+        return select;
+    };
+    auto add_switch = [this](const char *name) {
+        auto *sw = new GreeACSwitch();
+        this->switches_.emplace_back(name, sw);
+        return sw;
+    };
+    (void) add_select;
+    (void) add_switch;
+
+#ifndef GREE_AC_NO_VERTICAL_SWING_SELECT
+    this->ac_->set_vertical_swing_select(add_select("vertical_swing", option_names(vertical_swing_options::OPTIONS)));
+#endif
+#ifndef GREE_AC_NO_HORIZONTAL_SWING_SELECT
+    this->ac_->set_horizontal_swing_select(add_select("horizontal_swing", option_names(horizontal_swing_options::OPTIONS)));
+#endif
+#ifndef GREE_AC_NO_DISPLAY_SELECT
+    this->ac_->set_display_select(add_select("display", option_names(display_options::OPTIONS)));
+#endif
+#ifndef GREE_AC_NO_DISPLAY_UNIT_SELECT
+    this->ac_->set_display_unit_select(add_select("display_unit", option_names(display_unit_options::OPTIONS)));
+#endif
+#ifndef GREE_AC_NO_LIGHT_SELECT
+    this->ac_->set_light_select(add_select("light", option_names(light_options::OPTIONS)));
+#endif
+#ifndef GREE_AC_NO_QUIET_SELECT
+    this->ac_->set_quiet_select(add_select("quiet", option_names(quiet_options::OPTIONS)));
+#endif
+#ifndef GREE_AC_NO_IONIZER_SWITCH
+    this->ac_->set_ionizer_switch(add_switch("ionizer"));
+#endif
+#ifndef GREE_AC_NO_BEEPER_SWITCH
+    this->ac_->set_beeper_switch(add_switch("beeper"));
+#endif
+#ifndef GREE_AC_NO_SLEEP_SWITCH
+    this->ac_->set_sleep_switch(add_switch("sleep"));
+#endif
+#ifndef GREE_AC_NO_XFAN_SWITCH
+    this->ac_->set_xfan_switch(add_switch("xfan"));
+#endif
+#ifndef GREE_AC_NO_POWERSAVE_SWITCH
+    this->ac_->set_powersave_switch(add_switch("powersave"));
+#endif
+#ifndef GREE_AC_NO_TURBO_SWITCH
+    this->ac_->set_turbo_switch(add_switch("turbo"));
+#endif
+#ifndef GREE_AC_NO_IFEEL_SWITCH
+    this->ac_->set_ifeel_switch(add_switch("ifeel"));
+#endif
+#ifndef GREE_AC_NO_ENABLE_TX_SWITCH
+    this->ac_->set_enable_tx_switch(add_switch("enable_tx"));
+#endif
+#ifndef GREE_AC_NO_DUMP_PACKETS_SWITCH
+    this->ac_->set_dump_packets_switch(add_switch("dump_packets"));
+#endif
+#ifndef GREE_AC_NO_MODEL_ID_TEXT_SENSOR
+    this->ac_->set_model_id_text_sensor(&this->model_id_);
+#endif
+    this->ac_->set_state_snapshot_text_sensor(&this->snapshot_);
+}
+
+GreeACSelect *Rig::select(const std::string &name)
+{
+    for (auto &entry : this->selects_) {
+        if (entry.first == name)
+            return entry.second.get();
+    }
+    return nullptr;
+}
+
+GreeACSwitch *Rig::sw(const std::string &name)
+{
+    for (auto &entry : this->switches_) {
+        if (entry.first == name)
+            return entry.second.get();
+    }
+    return nullptr;
+}
+
+void Rig::setup()
+{
+    this->ac_->setup();
+    this->ac_->dump_config();
+}
+
+void Rig::step()
+{
+    this->deliver_due_bytes_();
+    this->ac_->loop();
+    uint32_t idle_ms = App.loop();  // due timeouts, the component is not registered
+
+    if (!this->simulated_)
+        return;
+    uint64_t pass_us = idle_ms > 0 ? (uint64_t) idle_ms * 1000 : HIGH_FREQ_PASS_US;
+    if (idle_ms == 0)
+        this->high_freq_us_ += pass_us;
+    this->elapsed_us_ += pass_us;
+    host::advance_time_us(pass_us);
+}
+
+void Rig::run_for(uint32_t ms)
+{
+    uint64_t end = host::time_us() + (uint64_t) ms * 1000;
+    while (host::time_us() < end)
+        this->step();
+}
+
+void Rig::run_until_idle(uint32_t max_ms)
+{
+    uint64_t end = host::time_us() + (uint64_t) max_ms * 1000;
+    do {
+        this->step();
+    } while ((this->unit_bytes_pending() || this->ac_->frame_pending() || this->ac_->publish_pending()) &&
+             host::time_us() < end);
+}
+
+void Rig::send_from_unit(const uint8_t *data, size_t len, bool wire_speed)
+{
+    if (!wire_speed) {
+        this->uart_.inject(data, len);
+        return;
+    }
+    uint64_t due = this->rx_schedule_.empty() ? host::time_us() : this->rx_schedule_.back().due_us;
+    for (size_t i = 0; i < len; i++) {
+        due += BYTE_US;
+        this->rx_schedule_.push_back({due, data[i]});
+    }
+}
+
+void Rig::deliver_due_bytes_()
+{
+    uint64_t now = host::time_us();
+    while (!this->rx_schedule_.empty() && this->rx_schedule_.front().due_us <= now) {
+        this->uart_.inject(&this->rx_schedule_.front().value, 1);
+        this->rx_schedule_.pop_front();
+    }
+}
+
+void Rig::on_write_(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (!serial_process_feed(&this->tx_framer_, data[i]))
+            continue;
+        TxFrame frame{millis(), std::vector<uint8_t>(this->tx_framer_.data, this->tx_framer_.data + this->tx_framer_.size)};
+        serial_process_reset(&this->tx_framer_);
+        if (this->on_tx)
+            this->on_tx(frame);
+    }
+}
+
+std::string hex_frame(const uint8_t *data, size_t len)
+{
+    std::string out;
+    char byte[4];
+    for (size_t i = 0; i < len; i++) {
+        snprintf(byte, sizeof(byte), i == 0 ? "%02X" : ".%02X", data[i]);
+        out += byte;
+    }
+    return out;
+}
+
+}  // namespace gree_ac_host
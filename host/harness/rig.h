@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "esphome/components/uart/uart.h"
+#include "gree_ac_cnt.h"
+#include "gree_ac_select.h"
+#include "gree_ac_switch.h"
+
+namespace gree_ac_host {
+
+using namespace esphome;
+
+/* GreeACCNT with what the harnesses look at made public */
+class HostGreeAC : public gree_ac::CNT::GreeACCNT {
+    public:
+        bool ready() const { return this->state_ == gree_ac::CNT::ACState::Ready; }
+        bool frame_pending() const { return this->serialProcess_.size > 0; }
+        bool publish_pending() const { return this->publish_pending_ != 0; }
+        uint32_t rx_frames() const { return this->rx_frames_; }
+        uint32_t rx_errors() const { return this->rx_errors_; }
+        uint32_t tx_frames() const { return this->tx_frames_; }
+        uint32_t confirmed() const { return this->confirm_latency_.count(); }
+        uint32_t confirm_timeouts() const { return this->confirm_timeouts_; }
+        uint32_t confirm_max_ms() const { return this->confirm_latency_.max(); }
+        uint8_t quiet() const { return this->quiet_state_; }
+        bool turbo() const { return this->turbo_state_; }
+};
+
+struct TxFrame {
+    uint32_t time_ms;
+    std::vector<uint8_t> data;
+};
+
+/*
+ * The component wired up the way climate.py does it (every entity the build has, state snapshot on) on the
+ * stub UART. Bytes from the unit are delivered at 4800 8E1 pace or all at once; the frames the component
+ * sends are cut out of the TX stream and handed to on_tx.
+ *
+ * With simulated time every step() is one App.loop() pass: afterwards the clock moves on by the loop
+ * interval, or by HIGH_FREQ_PASS_US while the component asks for high-frequency looping.
+ */
+class Rig {
+    public:
+        static const uint32_t BYTE_US = 11 * 1000000 / 4800;  // 8E1 = 11 bits per byte
+        static const uint32_t HIGH_FREQ_PASS_US = 1000;
+
+        explicit Rig(bool simulated_time = true);
+
+        HostGreeAC &ac() { return *this->ac_; }
+        uart::UARTComponent &uart() { return this->uart_; }
+        text_sensor::TextSensor &snapshot() { return this->snapshot_; }
+        gree_ac::GreeACSelect *select(const std::string &name);
+        gree_ac::GreeACSwitch *sw(const std::string &name);
+
+        void setup();
+        void step();
+        void run_for(uint32_t ms);
+        /* steps until every byte is delivered and read, the frame handled and all entities published */
+        void run_until_idle(uint32_t max_ms = 10000);
+
+        /* a frame from the unit, starting after the bytes still on their way */
+        void send_from_unit(const uint8_t *data, size_t len, bool wire_speed = true);
+        bool unit_bytes_pending() const { return !this->rx_schedule_.empty() || this->uart_.rx_pending() > 0; }
+
+        uint64_t elapsed_us() const { return this->elapsed_us_; }
+        uint64_t high_freq_us() const { return this->high_freq_us_; }
+
+        std::function<void(const TxFrame &)> on_tx;
+
+    protected:
+        struct ScheduledByte {
+            uint64_t due_us;
+            uint8_t value;
+        };
+
+        void deliver_due_bytes_();
+        void on_write_(const uint8_t *data, size_t len);
+
+        bool simulated_;
+        uart::UARTComponent uart_;
+        std::unique_ptr<HostGreeAC> ac_;
+        std::vector<std::pair<std::string, std::unique_ptr<gree_ac::GreeACSelect>>> selects_;
+        std::vector<std::pair<std::string, std::unique_ptr<gree_ac::GreeACSwitch>>> switches_;
+        text_sensor::TextSensor model_id_;
+        text_sensor::TextSensor snapshot_;
+
+        std::deque<ScheduledByte> rx_schedule_;
+        gree_ac::SerialProcess_t tx_framer_;
+        uint64_t elapsed_us_ = 0;
+        uint64_t high_freq_us_ = 0;
+};
+
+std::string hex_frame(const uint8_t *data, size_t len);
+
+}  // namespace gree_ac_host
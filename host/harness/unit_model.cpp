@@ -0,0 +1,127 @@
+#include "unit_model.h"
+
+#include <cstring>
+
+#include "esphome/core/host.h"
+
+namespace gree_ac_host {
+
+using namespace esphome::gree_ac;
+using namespace esphome::gree_ac::CNT;
+
+static const uint8_t CMD_IN_TIME_REPLY = 0x35;  /* not decoded by the component */
+
+/* (byte, mask) of everything a set frame with 0xAF changes, same layout as the report */
+static const FieldMask_t SETTABLE_FIELDS[] = {
+    {0, 0b00000100},   /* ionizer 2 */
+    {4, 0b11111111},   /* power, mode, sleep, fan speed 2 */
+    {5, 0b11110000},   /* target temperature */
+    {6, 0b00001111},   /* x-fan, ionizer 1, display on, turbo */
+    {7, 0b10000000},   /* display unit */
+    {8, 0b11110111},   /* vertical / horizontal swing */
+    {9, 0b01110000},   /* i-feel, display mode */
+    {11, 0b01000000},  /* powersave */
+    {16, 0b00001100},  /* quiet, quiet auto */
+    {18, 0b00000111},  /* fan speed 1 */
+    {40, 0b00000001},  /* beeper off */
+};
+
+/* heating, 24 degrees, fan auto - first sample in documents/protocol.txt */
+static const uint8_t INITIAL_REPORT[45] = {
+    0x04, 0x00, 0x40, 0x00, 0xC0, 0x80, 0x0C, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x00,
+};
+
+static const uint8_t MODEL_ID_PAYLOAD[24] = {0x01, 0x00, 0x01, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0,    0,    0,    0, 0, 0, 0, 0, 0, 0, 0, 0x01};
+static const uint8_t TIME_REPLY_PAYLOAD[45] = {0x04, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                               0x00, 0x01, 0xE0, 0x00, 0x00, 0x39, 0x39, 0x3E};
+
+SimulatedUnit::SimulatedUnit(Rig &rig) : rig_(rig)
+{
+    memcpy(this->report_, INITIAL_REPORT, sizeof(this->report_));
+    this->last_traffic_us_ = esphome::host::time_us();
+}
+
+bool SimulatedUnit::power() const
+{
+    return (this->report_[protocol::REPORT_PWR_BYTE] & protocol::REPORT_PWR_MASK) != 0;
+}
+
+uint8_t SimulatedUnit::target() const
+{
+    return ((this->report_[protocol::REPORT_TEMP_SET_BYTE] & protocol::REPORT_TEMP_SET_MASK) >> protocol::REPORT_TEMP_SET_POS) +
+           protocol::REPORT_TEMP_SET_OFF;
+}
+
+void SimulatedUnit::on_frame(const TxFrame &frame)
+{
+    uint64_t now = esphome::host::time_us();
+    this->last_traffic_us_ = now;
+    this->frames_++;
+
+    const std::vector<uint8_t> &data = frame.data;
+    if (data.size() < 5 || frame_checksum(data.data(), data.size()) != data.back()) {
+        this->bad_frames_++;
+        return;
+    }
+
+    uint8_t cmd = data[3];
+    this->cmd_counts_[cmd]++;
+    const uint8_t *payload = &data[4];
+    size_t payload_len = data.size() - 5;
+    uint64_t due = now + (uint64_t) LATENCY_MS * 1000;
+
+    switch (cmd) {
+        case protocol::CMD_OUT_PARAMS_SET:
+            if (payload_len >= sizeof(this->report_) && payload[protocol::SET_AF_BYTE] == protocol::SET_AF_VAL) {
+                for (const FieldMask_t &field : SETTABLE_FIELDS)
+                    this->report_[field.byte] = (this->report_[field.byte] & ~field.mask) | (payload[field.byte] & field.mask);
+                this->applied_++;
+            }
+            this->send_report_(due);
+            break;
+        case protocol::CMD_OUT_MAC_REPORT:
+            this->answer_(protocol::CMD_IN_MODEL_ID, MODEL_ID_PAYLOAD, sizeof(MODEL_ID_PAYLOAD), due);
+            break;
+        case protocol::CMD_OUT_SYNC_TIME:
+            this->answer_(CMD_IN_TIME_REPLY, TIME_REPLY_PAYLOAD, sizeof(TIME_REPLY_PAYLOAD), due);
+            break;
+        default:
+            break;
+    }
+}
+
+void SimulatedUnit::poll()
+{
+    uint64_t now = esphome::host::time_us();
+    while (!this->pending_.empty() && this->pending_.front().due_us <= now) {
+        const std::vector<uint8_t> &frame = this->pending_.front().frame;
+        this->rig_.send_from_unit(frame.data(), frame.size());
+        this->last_traffic_us_ = now;
+        this->pending_.pop_front();
+    }
+
+    if (now - this->last_traffic_us_ >= (uint64_t) REPORT_INTERVAL_MS * 1000) {
+        this->last_traffic_us_ = now;
+        this->send_report_(now);
+    }
+}
+
+void SimulatedUnit::answer_(uint8_t cmd, const uint8_t *payload, size_t len, uint64_t due_us)
+{
+    std::vector<uint8_t> frame = {protocol::SYNC, protocol::SYNC, (uint8_t) (len + 2), cmd};
+    frame.insert(frame.end(), payload, payload + len);
+    frame.push_back(0);
+    frame.back() = frame_checksum(frame.data(), frame.size());
+    this->pending_.push_back({due_us, std::move(frame)});
+}
+
+void SimulatedUnit::send_report_(uint64_t due_us)
+{
+    this->reports_++;
+    this->answer_(protocol::CMD_IN_UNIT_REPORT, this->report_, sizeof(this->report_), due_us);
+}
+
+}  // namespace gree_ac_host
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "rig.h"
+
+namespace gree_ac_host {
+
+/*
+ * The AC unit side of the bus, the model of sniffer/simulate_unit.py: it keeps a report, applies set frames
+ * carrying 0xAF to it and answers every set frame with a report, MAC report frames with the model id and
+ * time sync frames with the time reply, LATENCY_MS after the frame. Without traffic for REPORT_INTERVAL_MS
+ * it sends a report on its own. No room temperature drift, so a run only depends on the component.
+ */
+class SimulatedUnit {
+    public:
+        static const uint32_t LATENCY_MS = 50;
+        static const uint32_t REPORT_INTERVAL_MS = 1000;
+
+        explicit SimulatedUnit(Rig &rig);
+
+        /* hook for Rig::on_tx */
+        void on_frame(const TxFrame &frame);
+        /* sends what is due, call once per Rig::step() */
+        void poll();
+
+        bool power() const;
+        uint8_t target() const;
+        /* the masked bits of a report byte, e.g. protocol::REPORT_VSWING_BYTE / _MASK */
+        uint8_t field(uint8_t byte, uint8_t mask) const { return this->report_[byte] & mask; }
+
+        uint32_t frames() const { return this->frames_; }
+        uint32_t bad_frames() const { return this->bad_frames_; }
+        uint32_t applied() const { return this->applied_; }
+        uint32_t reports() const { return this->reports_; }
+        uint32_t count(uint8_t cmd) const { return this->cmd_counts_[cmd]; }
+
+    protected:
+        struct Answer {
+            uint64_t due_us;
+            std::vector<uint8_t> frame;
+        };
+
+        void answer_(uint8_t cmd, const uint8_t *payload, size_t len, uint64_t due_us);
+        void send_report_(uint64_t due_us);
+
+        Rig &rig_;
+        uint8_t report_[45];
+        std::deque<Answer> pending_;
+        uint64_t last_traffic_us_ = 0;
+
+        uint32_t frames_ = 0;
+        uint32_t bad_frames_ = 0;
+        uint32_t applied_ = 0;
+        uint32_t reports_ = 0;
+        uint32_t cmd_counts_[256] = {};
+};
+
+}  // namespace gree_ac_host
@@ -0,0 +1,74 @@
+/*
+ * A loop budget which every pass overruns, against the simulated unit: 1 ms, with every reading of the cycle
+ * counter 1 ms after the one before. The budget may only thin out publishing and packet dumps:
+ *
+ *   - frames to the unit still go out every refresh period,
+ *   - every pass still publishes one entity, so the state reaches the climate entity and the snapshot,
+ *   - a command is still sent and confirmed.
+ */
+#include <cstdio>
+#include <string>
+
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+#include "harness/rig.h"
+#include "harness/unit_model.h"
+
+using namespace gree_ac_host;
+using namespace esphome;
+
+static const uint32_t RUN_MS = 10000;
+/* refresh period plus the 50 byte report and the unit's latency, with room for a MAC or sync frame */
+static const uint32_t MAX_TX_GAP_MS = 1000;
+
+static int failures = 0;
+
+static void expect(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+    if (!ok)
+        failures++;
+}
+
+int main()
+{
+    host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+
+    Rig rig;
+    SimulatedUnit unit(rig);
+    uint32_t last_tx_ms = 0;
+    uint32_t max_gap_ms = 0;
+    rig.on_tx = [&](const TxFrame &frame) {
+        if (last_tx_ms != 0 && frame.time_ms - last_tx_ms > max_gap_ms)
+            max_gap_ms = frame.time_ms - last_tx_ms;
+        last_tx_ms = frame.time_ms;
+        unit.on_frame(frame);
+    };
+    std::string snapshot;
+    rig.snapshot().add_on_state_callback([&](const std::string &state) { snapshot = state; });
+
+    host::set_cycles_per_reading(1000000);
+    rig.ac().set_loop_budget(1000);
+    rig.setup();
+
+    auto run = [&](uint32_t ms) {
+        uint32_t end = millis() + ms;
+        while ((int32_t) (millis() - end) < 0) {
+            unit.poll();
+            rig.step();
+        }
+    };
+
+    run(RUN_MS / 2);
+    rig.ac().make_call().set_target_temperature(27).perform();
+    run(RUN_MS / 2);
+
+    printf("max TX gap %u ms, snapshot %s\n", (unsigned) max_gap_ms, snapshot.c_str());
+    expect(rig.ac().ready(), "talking to the unit");
+    expect(max_gap_ms <= MAX_TX_GAP_MS, "frames to the unit on time");
+    expect(snapshot.find("\"t\":27.0") != std::string::npos, "state published");
+    expect(unit.target() == 27 && rig.ac().confirmed() == 1, "command sent and confirmed");
+
+    printf("%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/*
+ * A frame from the unit which stops halfway (unit reset, line glitch) is dropped after READ_TIMEOUT:
+ *
+ *   - while its bytes come in the frame is pending and the loop runs at high frequency,
+ *   - once the line is quiet for longer than READ_TIMEOUT it is gone and the loop falls back to the
+ *     normal interval, apart from the lead before each TX slot,
+ *   - the next complete frame is handled as usual.
+ */
+#include <cstdio>
+#include <vector>
+
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+#include "harness/rig.h"
+
+using namespace gree_ac_host;
+using namespace esphome;
+using namespace esphome::gree_ac;
+
+/* READ_TIMEOUT is 100 ms */
+static const uint32_t PENDING_CHECK_MS = 50;
+static const uint32_t DROPPED_CHECK_MS = 200;
+/* the high frequency share of an idle component is the TX lead over the refresh period, well below half */
+static const uint32_t IDLE_WINDOW_MS = 5000;
+
+static int failures = 0;
+
+static void expect(bool ok, const char *what)
+{
+    printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+    if (!ok)
+        failures++;
+}
+
+int main()
+{
+    host::set_log_level(ESPHOME_LOG_LEVEL_ERROR);
+
+    /* the first report of documents/protocol.txt */
+    std::vector<uint8_t> report = {0x7E, 0x7E, 0x2F, 0x31, 0x04, 0x00, 0x40, 0x00, 0xC0, 0x80, 0x0C, 0x02, 0x00};
+    report.resize(4 + 45, 0x00);
+    report[4 + 18] = 0x08;
+    report[4 + 42] = 0x3E;
+    report.push_back(0);
+    report.back() = frame_checksum(report.data(), report.size());
+
+    Rig rig;
+    rig.setup();
+    rig.run_for(1000);
+
+    rig.send_from_unit(report.data(), 20);
+    rig.run_for(PENDING_CHECK_MS);
+    expect(rig.ac().frame_pending(), "partial frame pending while its bytes come in");
+
+    rig.run_for(DROPPED_CHECK_MS - PENDING_CHECK_MS);
+    expect(!rig.ac().frame_pending(), "partial frame dropped after the timeout");
+
+    uint64_t elapsed_us = rig.elapsed_us();
+    uint64_t high_freq_us = rig.high_freq_us();
+    rig.run_for(IDLE_WINDOW_MS);
+    double share = (double) (rig.high_freq_us() - high_freq_us) / (double) (rig.elapsed_us() - elapsed_us);
+    printf("high frequency afterwards %.1f %%\n", share * 100.0);
+    expect(share < 0.5, "loop back to the normal interval");
+
+    rig.send_from_unit(report.data(), report.size());
+    rig.run_until_idle();
+    expect(rig.ac().rx_frames() == 1 && rig.ac().rx_errors() == 0, "next frame handled");
+    expect(rig.ac().ready(), "talking to the unit");
+
+    printf("%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
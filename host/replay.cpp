@@ -0,0 +1,133 @@
+/*
+ * gree_replay: feeds the unit side of a GCAP capture into the component on the stub UART and prints what it
+ * sends back and how its state snapshot moves.
+ *
+ *   gree_replay CAPTURE [--fast] [--record OUT.gcap] [--trace N] [-v]
+ *
+ * Runs on simulated time: at the captured pace (the frame bytes at 4800 baud) by default, or every frame as
+ * soon as the previous one is handled with --fast. --record writes both directions of the replay to a new
+ * capture, so two builds can be diffed on the same trace. --trace keeps the last N latency trace points and
+ * prints them at the end like gree_ac.dump_trace, for sniffer/trace2chrome.py. -v shows the component log.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+#include "harness/gcap.h"
+#include "harness/rig.h"
+
+using namespace gree_ac_host;
+
+static void usage()
+{
+    fprintf(stderr, "usage: gree_replay CAPTURE [--fast] [--record OUT.gcap] [--trace N] [-v]\n");
+}
+
+/* without -v only the trace dump is shown, as the bare TRACE lines */
+static void trace_only(int level, const char *tag, const char *message)
+{
+    if (level <= ESPHOME_LOG_LEVEL_ERROR || strcmp(tag, "gree_ac.trace") == 0)
+        printf("%s\n", message);
+}
+
+int main(int argc, char **argv)
+{
+    std::string capture;
+    std::string record;
+    bool fast = false;
+    bool verbose = false;
+    uint16_t trace_entries = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fast") == 0) {
+            fast = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_entries = (uint16_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (argv[i][0] != '-' && capture.empty()) {
+            capture = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (capture.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::vector<GcapRecord> records;
+    std::string error;
+    if (!read_gcap(capture, &records, &error)) {
+        fprintf(stderr, "%s: %s\n", capture.c_str(), error.c_str());
+        return 1;
+    }
+
+    GcapWriter writer;
+    if (!record.empty() && !writer.open(record)) {
+        fprintf(stderr, "%s: cannot write\n", record.c_str());
+        return 1;
+    }
+
+    if (verbose) {
+        esphome::host::set_log_level(ESPHOME_LOG_LEVEL_DEBUG);
+    } else if (trace_entries > 0) {
+        esphome::host::set_log_level(ESPHOME_LOG_LEVEL_INFO);
+        esphome::host::set_log_sink(&trace_only);
+    } else {
+        esphome::host::set_log_level(ESPHOME_LOG_LEVEL_NONE);
+    }
+
+    Rig rig;
+    rig.on_tx = [&](const TxFrame &frame) {
+        printf("%10u TX %s\n", frame.time_ms, hex_frame(frame.data.data(), frame.data.size()).c_str());
+        if (!record.empty())
+            writer.write(frame.time_ms, GCAP_TO_UNIT, frame.data.data(), frame.data.size());
+    };
+    rig.snapshot().add_on_state_callback([](const std::string &state) {
+        printf("%10u STATE %s\n", esphome::millis(), state.c_str());
+    });
+    if (trace_entries > 0)
+        rig.ac().set_trace_buffer_size(trace_entries);
+    rig.setup();
+
+    size_t replayed = 0;
+    uint32_t start_ms = esphome::millis();
+    uint32_t first_ms = 0;
+    bool first = true;
+
+    for (const GcapRecord &rec : records) {
+        if (rec.direction != GCAP_FROM_UNIT)
+            continue;
+        if (first) {
+            first_ms = rec.time_ms;
+            first = false;
+        }
+        if (fast) {
+            rig.run_until_idle();
+        } else {
+            while ((int32_t) (esphome::millis() - start_ms - (rec.time_ms - first_ms)) < 0)
+                rig.step();
+        }
+        if (!record.empty())
+            writer.write(esphome::millis(), GCAP_FROM_UNIT, rec.frame.data(), rec.frame.size());
+        rig.send_from_unit(rec.frame.data(), rec.frame.size(), !fast);
+        replayed++;
+    }
+    rig.run_until_idle();
+    writer.close();
+    if (trace_entries > 0)
+        rig.ac().dump_trace();
+
+    printf("%zu frames replayed: %u valid, %u invalid, %u frames sent\n", replayed, rig.ac().rx_frames(),
+           rig.ac().rx_errors(), rig.ac().tx_frames());
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * gree_simulate: the component against the simulated unit for hours of protocol time, on simulated time.
+ *
+ *   gree_simulate [--hours H] [--wrap] [--command-interval S] [-v]
+ *
+ * Every --command-interval seconds (default 60) the target temperature is changed. --wrap starts the
+ * component clock ten minutes before the 32 bit millis() wraparound (set_clock_offset()). Fails if
+ *   - the gap between two frames the component sends exceeds MAX_TX_GAP_MS,
+ *   - the component leaves Ready after the first report,
+ *   - a command is not confirmed by the unit, or the MAC and time sync cycles stop.
+ * Prints the frame counts and the share of time spent looping at high frequency.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+#include "harness/rig.h"
+#include "harness/unit_model.h"
+
+using namespace gree_ac_host;
+using namespace esphome::gree_ac::CNT;
+
+/* refresh period plus the 50 byte report and the unit's latency, with room for a MAC or sync frame */
+static const uint32_t MAX_TX_GAP_MS = 1000;
+/* no command in the last seconds, so the last one is confirmed within the run */
+static const uint32_t CONFIRM_WAIT_MS = 5000;
+static const uint32_t WRAP_LEAD_MS = 10 * 60 * 1000;
+
+int main(int argc, char **argv)
+{
+    double hours = 1.0;
+    bool wrap = false;
+    bool verbose = false;
+    uint32_t command_interval_s = 60;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) {
+            hours = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--command-interval") == 0 && i + 1 < argc) {
+            command_interval_s = (uint32_t) atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--wrap") == 0) {
+            wrap = true;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "usage: gree_simulate [--hours H] [--wrap] [--command-interval S] [-v]\n");
+            return 2;
+        }
+    }
+
+    esphome::host::set_log_level(verbose ? ESPHOME_LOG_LEVEL_DEBUG : ESPHOME_LOG_LEVEL_ERROR);
+
+    Rig rig;
+    SimulatedUnit unit(rig);
+    uint32_t last_tx_ms = 0;
+    uint32_t max_gap_ms = 0;
+    uint32_t max_gap_at_ms = 0;
+    bool first_tx = true;
+    rig.on_tx = [&](const TxFrame &frame) {
+        if (!first_tx && frame.time_ms - last_tx_ms > max_gap_ms) {
+            max_gap_ms = frame.time_ms - last_tx_ms;
+            max_gap_at_ms = frame.time_ms;
+        }
+        first_tx = false;
+        last_tx_ms = frame.time_ms;
+        unit.on_frame(frame);
+    };
+
+    if (wrap)
+        rig.ac().set_clock_offset(0u - WRAP_LEAD_MS);
+    rig.setup();
+
+    uint64_t end_ms = (uint64_t) (hours * 3600 * 1000);
+    uint64_t next_command_ms = (uint64_t) command_interval_s * 1000;
+    uint32_t commands = 0;
+    uint32_t not_ready_ms = 0;
+    bool was_ready = false;
+    uint8_t target = 24;
+
+    auto step = [&]() {
+        uint32_t before = esphome::millis();
+        unit.poll();
+        rig.step();
+        bool ready = rig.ac().ready();
+        if (was_ready && !ready)
+            not_ready_ms += esphome::millis() - before;
+        was_ready |= ready;
+    };
+
+    while (esphome::host::time_us() / 1000 < end_ms) {
+        step();
+        if (command_interval_s > 0 && esphome::host::time_us() / 1000 + CONFIRM_WAIT_MS < end_ms &&
+            esphome::host::time_us() / 1000 >= next_command_ms) {
+            next_command_ms += (uint64_t) command_interval_s * 1000;
+            target = target == 24 ? 26 : 24;
+            rig.ac().make_call().set_target_temperature(target).perform();
+            commands++;
+        }
+    }
+
+    double high_freq = rig.elapsed_us() > 0 ? 100.0 * rig.high_freq_us() / rig.elapsed_us() : 0;
+    printf("%.2f h simulated%s: %u frames sent (set %u, sync %u, MAC %u), %u reports, %u applied\n", hours,
+           wrap ? " across the millis() wraparound" : "", unit.frames(), unit.count(protocol::CMD_OUT_PARAMS_SET),
+           unit.count(protocol::CMD_OUT_SYNC_TIME), unit.count(protocol::CMD_OUT_MAC_REPORT), unit.reports(),
+           unit.applied());
+    printf("max TX gap %u ms (at %u ms), %u commands, %u confirmed (max %u ms), %u timeouts, unit target %u, high frequency %.1f %%\n",
+           max_gap_ms, max_gap_at_ms, commands, rig.ac().confirmed(), rig.ac().confirm_max_ms(), rig.ac().confirm_timeouts(),
+           unit.target(), high_freq);
+
+    bool ok = true;
+    auto fail = [&](const char *what) {
+        printf("FAIL: %s\n", what);
+        ok = false;
+    };
+    uint32_t expected_syncs = (uint32_t) (hours * 3600 / 10) / 2;
+    uint32_t expected_macs = (uint32_t) (hours * 60) * 6 / 2;
+    if (max_gap_ms > MAX_TX_GAP_MS)
+        fail("TX gap");
+    if (!was_ready || not_ready_ms > 0)
+        fail("component left Ready");
+    if (unit.bad_frames() > 0)
+        fail("bad frames at the unit");
+    if (rig.ac().confirmed() < commands || rig.ac().confirm_timeouts() > 0)
+        fail("command not confirmed");
+    if (commands > 0 && unit.target() != target)
+        fail("last command not applied");
+    if (unit.count(protocol::CMD_OUT_SYNC_TIME) < expected_syncs)
+        fail("time sync cycle");
+    if (unit.count(protocol::CMD_OUT_MAC_REPORT) < expected_macs)
+        fail("MAC cycle");
+    if (ok)
+        printf("OK\n");
+    return ok ? 0 : 1;
+}
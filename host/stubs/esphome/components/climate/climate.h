@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cmath>
+#include <initializer_list>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/string_ref.h"
+#include "climate_mode.h"
+
+namespace esphome {
+namespace climate {
+
+class Climate;
+
+class ClimateTraits {
+    public:
+        void add_feature_flags(uint32_t flags) { this->feature_flags_ |= flags; }
+        uint32_t get_feature_flags() const { return this->feature_flags_; }
+        void set_visual_min_temperature(float temperature) { this->visual_min_temperature_ = temperature; }
+        void set_visual_max_temperature(float temperature) { this->visual_max_temperature_ = temperature; }
+        void set_visual_temperature_step(float step) { this->visual_temperature_step_ = step; }
+        float get_visual_min_temperature() const { return this->visual_min_temperature_; }
+        float get_visual_max_temperature() const { return this->visual_max_temperature_; }
+        void set_supported_modes(std::initializer_list<ClimateMode> modes) { this->modes_ = modes; }
+        void set_supported_fan_modes(std::initializer_list<ClimateFanMode> modes) { this->fan_modes_ = modes; }
+        void set_supported_swing_modes(std::initializer_list<ClimateSwingMode> modes) { this->swing_modes_ = modes; }
+        /* the pointers are kept, not the strings */
+        void set_supported_custom_fan_modes(std::initializer_list<const char *> modes) { this->custom_fan_modes_ = modes; }
+        const std::vector<const char *> &get_supported_custom_fan_modes() const { return this->custom_fan_modes_; }
+        const char *find_custom_fan_mode(const char *mode) const;
+
+    protected:
+        uint32_t feature_flags_ = 0;
+        float visual_min_temperature_ = 10;
+        float visual_max_temperature_ = 30;
+        float visual_temperature_step_ = 0.1f;
+        std::vector<ClimateMode> modes_;
+        std::vector<ClimateFanMode> fan_modes_;
+        std::vector<ClimateSwingMode> swing_modes_;
+        std::vector<const char *> custom_fan_modes_;
+};
+
+/* a change request as Home Assistant sends it; perform() hands it to Climate::control() */
+class ClimateCall {
+    public:
+        explicit ClimateCall(Climate *parent) : parent_(parent) {}
+
+        ClimateCall &set_mode(ClimateMode mode) { this->mode_ = mode; return *this; }
+        ClimateCall &set_target_temperature(float temperature) { this->target_temperature_ = temperature; return *this; }
+        ClimateCall &set_fan_mode(ClimateFanMode fan_mode) { this->fan_mode_ = fan_mode; this->custom_fan_mode_ = nullptr; return *this; }
+        ClimateCall &set_fan_mode(const char *custom_fan_mode);
+        ClimateCall &set_swing_mode(ClimateSwingMode swing_mode) { this->swing_mode_ = swing_mode; return *this; }
+        void perform();
+
+        const optional<ClimateMode> &get_mode() const { return this->mode_; }
+        const optional<float> &get_target_temperature() const { return this->target_temperature_; }
+        const optional<ClimateFanMode> &get_fan_mode() const { return this->fan_mode_; }
+        const optional<ClimateSwingMode> &get_swing_mode() const { return this->swing_mode_; }
+        bool has_custom_fan_mode() const { return this->custom_fan_mode_ != nullptr; }
+        const char *get_custom_fan_mode() const { return this->custom_fan_mode_; }
+
+    protected:
+        Climate *parent_;
+        optional<ClimateMode> mode_;
+        optional<float> target_temperature_;
+        optional<ClimateFanMode> fan_mode_;
+        optional<ClimateSwingMode> swing_mode_;
+        const char *custom_fan_mode_ = nullptr;
+};
+
+class Climate {
+    friend class ClimateCall;
+
+    public:
+        virtual ~Climate() = default;
+
+        ClimateMode mode{CLIMATE_MODE_OFF};
+        ClimateAction action{CLIMATE_ACTION_OFF};
+        float current_temperature{NAN};
+        float target_temperature{NAN};
+        optional<ClimateFanMode> fan_mode;
+        ClimateSwingMode swing_mode{CLIMATE_SWING_OFF};
+
+        ClimateCall make_call() { return ClimateCall(this); }
+        void publish_state() { this->state_callback_.call(*this); }
+        void add_on_state_callback(std::function<void(Climate &)> &&callback) { this->state_callback_.add(std::move(callback)); }
+        ClimateTraits get_traits() { return this->traits(); }
+
+        bool has_custom_fan_mode() const { return this->custom_fan_mode_ != nullptr; }
+        StringRef get_custom_fan_mode() const { return StringRef(this->custom_fan_mode_); }
+
+    protected:
+        virtual void control(const ClimateCall &call) = 0;
+        virtual ClimateTraits traits() = 0;
+
+        /* one of the custom fan modes of the traits, anything else clears the custom fan mode */
+        bool set_custom_fan_mode_(const char *mode);
+
+        const char *custom_fan_mode_ = nullptr;
+        CallbackManager<void(Climate &)> state_callback_;
+};
+
+void log_climate(const char *tag, const char *prefix, const char *type, Climate *obj);
+
+}  // namespace climate
+}  // namespace esphome
+
+#define LOG_CLIMATE(prefix, type, obj) ::esphome::climate::log_climate(TAG, prefix, type, obj)
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/string_ref.h"
+
+namespace esphome {
+namespace select {
+
+class SelectTraits {
+    public:
+        void set_options(std::vector<std::string> options) { this->options_ = std::move(options); }
+        const std::vector<std::string> &get_options() const { return this->options_; }
+
+    protected:
+        std::vector<std::string> options_;
+};
+
+class Select;
+
+/* a user choosing an option; perform() hands it to Select::control() */
+class SelectCall {
+    public:
+        explicit SelectCall(Select *parent) : parent_(parent) {}
+
+        SelectCall &set_option(const std::string &option) { this->option_ = option; return *this; }
+        void perform();
+
+    protected:
+        Select *parent_;
+        std::string option_;
+};
+
+class Select {
+    friend class SelectCall;
+
+    public:
+        virtual ~Select() = default;
+
+        SelectTraits traits;
+        std::string state;
+
+        void publish_state(const std::string &state);
+        void publish_state(size_t index);
+        SelectCall make_call() { return SelectCall(this); }
+
+        bool has_state() const { return this->active_index_.has_value(); }
+        optional<size_t> active_index() const { return this->active_index_; }
+        StringRef current_option() const { return StringRef(this->state.c_str()); }
+        optional<size_t> index_of(const std::string &option) const;
+        optional<std::string> at(size_t index) const;
+        size_t size() const { return this->traits.get_options().size(); }
+
+        void add_on_state_callback(std::function<void(size_t)> &&callback) { this->state_callback_.add(std::move(callback)); }
+
+    protected:
+        virtual void control(const std::string &value) = 0;
+
+        optional<size_t> active_index_;
+        CallbackManager<void(size_t)> state_callback_;
+};
+
+}  // namespace select
+}  // namespace esphome
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cmath>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+    public:
+        virtual ~Sensor() = default;
+
+        float state{NAN};
+
+        void publish_state(float state)
+        {
+            this->state = state;
+            this->state_callback_.call(state);
+        }
+        void add_on_state_callback(std::function<void(float)> &&callback) { this->state_callback_.add(std::move(callback)); }
+
+    protected:
+        CallbackManager<void(float)> state_callback_;
+};
+
+}  // namespace sensor
+}  // namespace esphome
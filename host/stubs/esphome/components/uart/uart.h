@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace uart {
+
+/*
+ * Host UART: a receive buffer the harness fills with inject() and a write hook for what the component sends.
+ * Unlike a real driver it is not thread safe.
+ */
+class UARTComponent {
+    public:
+        /* bytes "on the wire" from the unit, read_byte() takes them in order */
+        void inject(const uint8_t *data, size_t len) { this->rx_.insert(this->rx_.end(), data, data + len); }
+        size_t rx_pending() const { return this->rx_.size(); }
+        void clear_rx() { this->rx_.clear(); }
+
+        /* called with every write_array() of the component */
+        void set_tx_callback(std::function<void(const uint8_t *, size_t)> &&callback) { this->tx_callback_ = std::move(callback); }
+
+        int available() const { return (int) this->rx_.size(); }
+        bool read_byte(uint8_t *data);
+        void write_array(const uint8_t *data, size_t len);
+
+    protected:
+        std::deque<uint8_t> rx_;
+        std::function<void(const uint8_t *, size_t)> tx_callback_;
+};
+
+class UARTDevice {
+    public:
+        UARTDevice() = default;
+        UARTDevice(UARTComponent *parent) : parent_(parent) {}
+
+        void set_uart_parent(UARTComponent *parent) { this->parent_ = parent; }
+
+        int available() { return this->parent_->available(); }
+        bool read_byte(uint8_t *data) { return this->parent_->read_byte(data); }
+        void write_array(const uint8_t *data, size_t len) { this->parent_->write_array(data, len); }
+        void flush() {}
+
+    protected:
+        UARTComponent *parent_ = nullptr;
+};
+
+}  // namespace uart
+}  // namespace esphome
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+/* the part of App the component and the harnesses use: component registry, loop and the scheduler */
+class Application {
+    public:
+        void register_component(Component *component) { this->components_.push_back(component); }
+        void setup();
+        /* one pass over all components plus the due timeouts, returns the ms until the next pass (0 = high frequency) */
+        uint32_t loop();
+        uint32_t get_loop_interval() const { return this->loop_interval_; }
+        void set_loop_interval(uint32_t interval_ms) { this->loop_interval_ = interval_ms; }
+        void feed_wdt() {}
+
+    protected:
+        std::vector<Component *> components_;
+        uint32_t loop_interval_ = 16;
+};
+
+extern Application App;  // NOLINT
+
+}  // namespace esphome
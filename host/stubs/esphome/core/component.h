@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float DATA;
+extern const float HARDWARE;
+}  // namespace setup_priority
+
+class Component {
+    public:
+        virtual ~Component();  // host only: drops the component's pending timeouts
+
+        virtual void setup() {}
+        virtual void loop() {}
+        virtual void dump_config() {}
+        virtual float get_setup_priority() const { return 0.0f; }
+
+        bool is_failed() const { return this->failed_; }
+        bool status_has_error() const { return this->error_; }
+
+    protected:
+        void mark_failed() { this->failed_ = true; }
+        void status_set_error(const char * /* message */ = nullptr) { this->error_ = true; }
+        void status_clear_error() { this->error_ = false; }
+        /* one-shot, run by App.loop() once due */
+        void set_timeout(uint32_t timeout_ms, std::function<void()> &&func);
+        void defer(std::function<void()> &&func) { this->set_timeout(0, std::move(func)); }
+
+        bool failed_ = false;
+        bool error_ = false;
+};
+
+template<typename T> class Parented {
+    public:
+        Parented() = default;
+        Parented(T *parent) : parent_(parent) {}
+
+        T *get_parent() const { return this->parent_; }
+        void set_parent(T *parent) { this->parent_ = parent; }
+
+    protected:
+        T *parent_ = nullptr;
+};
+
+}  // namespace esphome
@@ -0,0 +1,8 @@
+#pragma once
+
+/* host stand-in for the defines.h ESPHome generates, the component sees the same macros as on the host platform */
+#define USE_HOST
+
+#ifndef ESPHOME_LOG_LEVEL
+#define ESPHOME_LOG_LEVEL ESPHOME_LOG_LEVEL_DEBUG
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+/* flash and RAM are the same on a host, so PROGMEM is empty and reading it is a plain load */
+#define PROGMEM
+
+namespace esphome {
+
+/* host time, real or simulated, see host.h */
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+/* the cycle counter runs at 1 GHz on the host, so one cycle is one nanosecond of real time */
+uint32_t arch_get_cpu_cycle_count();
+uint32_t arch_get_cpu_freq_hz();
+
+inline uint8_t progmem_read_byte(const uint8_t *addr) { return *addr; }
+inline const char *progmem_read_ptr(const char *const *addr) { return *addr; }
+
+}  // namespace esphome
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "esphome/core/optional.h"
+
+namespace esphome {
+
+template<typename T> T clamp(T value, T min, T max)
+{
+    return value < min ? min : (max < value ? max : value);
+}
+
+/* a fixed, locally administered address on the host: 02:00:00:00:00:01 */
+void get_mac_address_raw(uint8_t *mac);
+
+template<typename... X> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+    public:
+        void add(std::function<void(Ts...)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+        void call(Ts... args)
+        {
+            for (auto &callback : this->callbacks_)
+                callback(args...);
+        }
+        size_t size() const { return this->callbacks_.size(); }
+
+    protected:
+        std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+/* while any requester is started, the loop runs back to back instead of every loop interval */
+class HighFrequencyLoopRequester {
+    public:
+        ~HighFrequencyLoopRequester() { this->stop(); }  // host only, harnesses create and drop components
+
+        void start();
+        void stop();
+        static bool is_high_frequency();
+
+    protected:
+        bool started_ = false;
+        static uint32_t num_requests;
+};
+
+}  // namespace esphome
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Host only: knobs of the stubs which ESPHome itself does not have.
+ *
+ * Time: millis(), micros() and delay() run on real time by default. A harness switches to simulated time
+ * and advances it itself, so hours of protocol time run in seconds and every run is repeatable.
+ *
+ * CPU cycles: arch_get_cpu_cycle_count() counts real nanoseconds; a harness can add a fixed number of
+ * cycles to every reading, which makes every loop pass look that much slower (e.g. to overrun a loop budget).
+ *
+ * Log: ESP_LOGx lines go to stdout as "[D][tag:line]: message", up to the runtime level; a sink replaces that.
+ */
+
+namespace esphome {
+namespace host {
+
+void use_simulated_time(uint64_t start_us = 0);
+bool simulated_time();
+void advance_time_us(uint64_t us);
+uint64_t time_us();
+
+void set_cycles_per_reading(uint32_t cycles);
+
+typedef void (*LogSink_t)(int level, const char *tag, const char *message);
+void set_log_level(int level);
+void set_log_sink(LogSink_t sink);  // nullptr = stdout
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+
+namespace esphome {
+
+/* non-owning view of a C string, as the climate custom modes hand it out */
+class StringRef {
+    public:
+        StringRef() = default;
+        StringRef(const char *str) : str_(str != nullptr ? str : "") {}
+
+        const char *c_str() const { return this->str_; }
+        size_t size() const { return strlen(this->str_); }
+        bool empty() const { return this->str_[0] == '\0'; }
+
+        bool operator==(const char *other) const { return strcmp(this->str_, other != nullptr ? other : "") == 0; }
+        bool operator!=(const char *other) const { return !(*this == other); }
+        bool operator==(const std::string &other) const { return other == this->str_; }
+        bool operator!=(const std::string &other) const { return !(*this == other); }
+
+    protected:
+        const char *str_ = "";
+};
+
+}  // namespace esphome
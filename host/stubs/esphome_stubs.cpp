@@ -0,0 +1,315 @@
+/*
+ * Implementation of the ESPHome stand-ins in stubs/, just enough for the component and the harnesses to run.
+ */
+#include "esphome/components/climate/climate.h"
+#include "esphome/components/select/select.h"
+#include "esphome/components/uart/uart.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/host.h"
+#include "esphome/core/log.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace esphome {
+
+Application App;  // NOLINT
+
+namespace setup_priority {
+const float DATA = 600.0f;
+const float HARDWARE = 800.0f;
+}  // namespace setup_priority
+
+/*
+ * Time
+ */
+
+static bool sim_enabled = false;
+static uint64_t sim_time_us = 0;
+
+static uint64_t real_time_us()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+namespace host {
+
+void use_simulated_time(uint64_t start_us)
+{
+    sim_enabled = true;
+    sim_time_us = start_us;
+}
+
+bool simulated_time() { return sim_enabled; }
+
+void advance_time_us(uint64_t us) { sim_time_us += us; }
+
+uint64_t time_us() { return sim_enabled ? sim_time_us : real_time_us(); }
+
+}  // namespace host
+
+uint32_t millis() { return (uint32_t) (host::time_us() / 1000); }
+uint32_t micros() { return (uint32_t) host::time_us(); }
+
+void delay(uint32_t ms)
+{
+    if (sim_enabled)
+        sim_time_us += (uint64_t) ms * 1000;
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {}
+
+static uint32_t cycles_per_reading = 0;
+static uint32_t extra_cycles = 0;
+
+namespace host {
+
+void set_cycles_per_reading(uint32_t cycles) { cycles_per_reading = cycles; }
+
+}  // namespace host
+
+uint32_t arch_get_cpu_cycle_count()
+{
+    extra_cycles += cycles_per_reading;
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count() + extra_cycles;
+}
+
+uint32_t arch_get_cpu_freq_hz() { return 1000000000; }
+
+/*
+ * Log
+ */
+
+static int log_level = ESPHOME_LOG_LEVEL;
+static host::LogSink_t log_sink = nullptr;
+
+namespace host {
+
+void set_log_level(int level) { log_level = level; }
+void set_log_sink(LogSink_t sink) { log_sink = sink; }
+
+}  // namespace host
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...)
+{
+    if (level > log_level)
+        return;
+
+    char message[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    if (log_sink != nullptr) {
+        log_sink(level, tag, message);
+        return;
+    }
+    static const char LETTERS[] = "-EWICDVV";
+    printf("[%c][%s:%d]: %s\n", LETTERS[level & 7], tag, line, message);
+}
+
+/*
+ * Helpers, component and application
+ */
+
+void get_mac_address_raw(uint8_t *mac)
+{
+    static const uint8_t HOST_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(mac, HOST_MAC, sizeof(HOST_MAC));
+}
+
+uint32_t HighFrequencyLoopRequester::num_requests = 0;
+
+void HighFrequencyLoopRequester::start()
+{
+    if (this->started_)
+        return;
+    this->started_ = true;
+    num_requests++;
+}
+
+void HighFrequencyLoopRequester::stop()
+{
+    if (!this->started_)
+        return;
+    this->started_ = false;
+    num_requests--;
+}
+
+bool HighFrequencyLoopRequester::is_high_frequency() { return num_requests > 0; }
+
+struct PendingTimeout {
+    Component *component;
+    uint32_t due;
+    std::function<void()> func;
+};
+static std::vector<PendingTimeout> timeouts;
+
+Component::~Component()
+{
+    for (size_t i = 0; i < timeouts.size();) {
+        if (timeouts[i].component == this)
+            timeouts.erase(timeouts.begin() + i);
+        else
+            i++;
+    }
+}
+
+void Component::set_timeout(uint32_t timeout_ms, std::function<void()> &&func)
+{
+    timeouts.push_back({this, millis() + timeout_ms, std::move(func)});
+}
+
+void Application::setup()
+{
+    for (Component *component : this->components_)
+        component->setup();
+}
+
+uint32_t Application::loop()
+{
+    for (Component *component : this->components_)
+        component->loop();
+
+    uint32_t now = millis();
+    for (size_t i = 0; i < timeouts.size();) {
+        if ((int32_t) (now - timeouts[i].due) >= 0) {
+            std::function<void()> func = std::move(timeouts[i].func);
+            timeouts.erase(timeouts.begin() + i);
+            func();
+        } else {
+            i++;
+        }
+    }
+    return HighFrequencyLoopRequester::is_high_frequency() ? 0 : this->loop_interval_;
+}
+
+/*
+ * Climate
+ */
+
+namespace climate {
+
+const char *ClimateTraits::find_custom_fan_mode(const char *mode) const
+{
+    for (const char *supported : this->custom_fan_modes_) {
+        if (strcmp(supported, mode) == 0)
+            return supported;
+    }
+    return nullptr;
+}
+
+ClimateCall &ClimateCall::set_fan_mode(const char *custom_fan_mode)
+{
+    this->custom_fan_mode_ = custom_fan_mode;
+    this->fan_mode_.reset();
+    return *this;
+}
+
+void ClimateCall::perform()
+{
+    /* like ESPHome, custom fan modes the traits do not list are dropped before control() sees the call */
+    if (this->custom_fan_mode_ != nullptr)
+        this->custom_fan_mode_ = this->parent_->get_traits().find_custom_fan_mode(this->custom_fan_mode_);
+    this->parent_->control(*this);
+}
+
+bool Climate::set_custom_fan_mode_(const char *mode)
+{
+    const char *found = mode != nullptr ? this->get_traits().find_custom_fan_mode(mode) : nullptr;
+    if (found == this->custom_fan_mode_)
+        return false;
+    this->custom_fan_mode_ = found;
+    return true;
+}
+
+void log_climate(const char *tag, const char *prefix, const char *type, Climate *obj)
+{
+    if (obj != nullptr)
+        esp_log_printf_(ESPHOME_LOG_LEVEL_CONFIG, tag, __LINE__, "%s%s", prefix, type);
+}
+
+}  // namespace climate
+
+/*
+ * Select
+ */
+
+namespace select {
+
+void Select::publish_state(const std::string &state)
+{
+    auto index = this->index_of(state);
+    if (index.has_value())
+        this->publish_state(*index);
+}
+
+void Select::publish_state(size_t index)
+{
+    if (index >= this->size())
+        return;
+    this->state = this->traits.get_options()[index];
+    this->active_index_ = index;
+    this->state_callback_.call(index);
+}
+
+optional<size_t> Select::index_of(const std::string &option) const
+{
+    const auto &options = this->traits.get_options();
+    for (size_t i = 0; i < options.size(); i++) {
+        if (options[i] == option)
+            return i;
+    }
+    return {};
+}
+
+optional<std::string> Select::at(size_t index) const
+{
+    if (index >= this->size())
+        return {};
+    return this->traits.get_options()[index];
+}
+
+void SelectCall::perform()
+{
+    if (this->parent_->index_of(this->option_).has_value())
+        this->parent_->control(this->option_);
+}
+
+}  // namespace select
+
+/*
+ * UART
+ */
+
+namespace uart {
+
+bool UARTComponent::read_byte(uint8_t *data)
+{
+    if (this->rx_.empty())
+        return false;
+    *data = this->rx_.front();
+    this->rx_.pop_front();
+    return true;
+}
+
+void UARTComponent::write_array(const uint8_t *data, size_t len)
+{
+    if (this->tx_callback_)
+        this->tx_callback_(data, len);
+}
+
+}  // namespace uart
+
+}  // namespace esphome
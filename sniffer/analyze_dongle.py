@@ -5,6 +5,8 @@ import sys
 import argparse
 import select
 
+import gcap
+
 # Protocol constants
 SYNC = 0x7E
 
@@ -19,12 +21,18 @@ def calculate_checksum(packet):
 def get_timestamp():
     return time.strftime("%H:%M:%S", time.localtime()) + f".{int(time.time() * 1000) % 1000:03d}"
 
+capture = None
+
 def log_packet(packet, direction):
     ts = get_timestamp()
     hex_data = format_hex_pretty(packet)
     length = len(packet)
     print(f"[{ts}] [{direction}] [{hex_data}] [{length}]")
 
+    # We play the unit, so what we receive comes from the module
+    if capture:
+        capture.write(gcap.DIR_TO_UNIT if direction == "RX" else gcap.DIR_FROM_UNIT, packet)
+
 def handle_rx_packet(ser, packet):
     # Reponse to MAC ADDRESS_REQUEST (0x04)
     if (packet[3] == 0x04):
@@ -43,8 +51,13 @@ def handle_rx_packet(ser, packet):
 def main():
     parser = argparse.ArgumentParser(description="Gree AC Serial Sniffer")
     parser.add_argument("--port", default="/dev/ttyUSB0", help="Serial port to use (default: /dev/ttyUSB0)")
+    parser.add_argument("--capture", help="Also write all packets to this .gcap file")
     args = parser.parse_args()
 
+    global capture
+    if args.capture:
+        capture = gcap.CaptureWriter(args.capture)
+
     port = args.port
     baud = 4800
 
@@ -145,6 +158,8 @@ def main():
         print(f"\n[{get_timestamp()}] Unexpected error: {e}")
     finally:
         ser.close()
+        if capture:
+            capture.close()
         print(f"[{get_timestamp()}] Serial port closed.")
 
 if __name__ == "__main__":
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Reports the RAM and flash taken by the gree_ac symbols of a firmware ELF, optionally against an older build."""
+import argparse
+import json
+import re
+import shutil
+import subprocess
+import sys
+
+# objdump -t -C: address, flags, section, size, name
+SYMBOL_LINE = re.compile(r"^([0-9a-f]+)\s.{7}\s(\S+)\s+([0-9a-f]+)\s+(.+)$")
+
+# output section -> memory it ends up in, ESP8266 and ESP32 linker scripts
+REGIONS = {
+    ".data": "dram",
+    ".rodata": "dram",
+    ".bss": "dram",
+    ".noinit": "dram",
+    ".dram0.data": "dram",
+    ".dram0.bss": "dram",
+    ".text": "iram",
+    ".iram0.text": "iram",
+    ".irom0.text": "flash",
+    ".flash.text": "flash",
+    ".flash.rodata": "flash",
+}
+
+OBJDUMPS = ["xtensa-lx106-elf-objdump", "xtensa-esp32-elf-objdump", "objdump"]
+
+
+def find_objdump(requested):
+    for candidate in [requested] if requested else OBJDUMPS:
+        if shutil.which(candidate):
+            return candidate
+    sys.exit("no objdump found, pass the one of the toolchain with --objdump")
+
+
+def load_symbols(objdump, elf, match):
+    """Returns {(region, name): size} of all sized symbols whose name contains match."""
+    output = subprocess.run([objdump, "-t", "-C", elf], check=True, capture_output=True, text=True).stdout
+    symbols = {}
+    for line in output.splitlines():
+        parsed = SYMBOL_LINE.match(line)
+        if not parsed:
+            continue
+        _, section, size, name = parsed.groups()
+        size = int(size, 16)
+        region = REGIONS.get(section)
+        if size == 0 or region is None or match not in name:
+            continue
+        key = (region, name.strip())
+        symbols[key] = symbols.get(key, 0) + size
+    return symbols
+
+
+def totals(symbols):
+    result = {region: 0 for region in sorted(set(REGIONS.values()))}
+    for (region, _), size in symbols.items():
+        result[region] += size
+    return result
+
+
+def report(symbols, baseline, top):
+    current = totals(symbols)
+    result = {"totals": current, "symbols": []}
+    if baseline is not None:
+        before = totals(baseline)
+        result["baseline"] = before
+        result["delta"] = {region: current[region] - before[region] for region in current}
+
+    keys = set(symbols) | set(baseline or {})
+    rows = []
+    for key in keys:
+        size = symbols.get(key, 0)
+        row = {"region": key[0], "name": key[1], "size": size}
+        if baseline is not None:
+            row["delta"] = size - baseline.get(key, 0)
+        rows.append(row)
+    # largest first, or largest change when comparing
+    sort_key = (lambda r: -abs(r["delta"])) if baseline is not None else (lambda r: -r["size"])
+    result["symbols"] = sorted(rows, key=sort_key)[:top]
+    return result
+
+
+def print_text(result):
+    compare = "delta" in result
+    print(f"{'region':<8}{'bytes':>10}" + (f"{'before':>10}{'delta':>10}" if compare else ""))
+    for region, size in result["totals"].items():
+        line = f"{region:<8}{size:>10}"
+        if compare:
+            line += f"{result['baseline'][region]:>10}{result['delta'][region]:>+10}"
+        print(line)
+    print()
+    for row in result["symbols"]:
+        if compare and row["delta"] == 0:
+            continue
+        line = f"{row['region']:<8}{row['size']:>8}"
+        if compare:
+            line += f"{row['delta']:>+8}"
+        print(f"{line}  {row['name']}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RAM/flash footprint of the gree_ac component in a firmware ELF")
+    parser.add_argument("elf", help="firmware.elf of the build, e.g. .esphome/build/<node>/.pioenvs/<node>/firmware.elf")
+    parser.add_argument("--baseline", help="firmware.elf of an older build to compare with")
+    parser.add_argument("--match", default="gree_ac", help="only count symbols containing this (default: gree_ac)")
+    parser.add_argument("--top", type=int, default=20, help="number of symbols to list (default: 20)")
+    parser.add_argument("--objdump", help="objdump of the toolchain (default: first one found in PATH)")
+    parser.add_argument("--json", action="store_true", help="print JSON instead of a table")
+    args = parser.parse_args()
+
+    objdump = find_objdump(args.objdump)
+    symbols = load_symbols(objdump, args.elf, args.match)
+    baseline = load_symbols(objdump, args.baseline, args.match) if args.baseline else None
+    result = report(symbols, baseline, args.top)
+
+    if args.json:
+        print(json.dumps(result))
+    else:
+        print_text(result)
+
+
+if __name__ == "__main__":
+    main()
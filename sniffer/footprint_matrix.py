@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Builds test_config.yaml in several variants for ESP8266 and ESP32 and tabulates the memory footprint of each."""
+import argparse
+import copy
+import csv
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+import yaml
+
+import footprint
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# same list as OPTIONAL_ENTITIES in components/gree_ac/climate.py
+ALL_ENTITIES = [
+    "horizontal_swing_select",
+    "vertical_swing_select",
+    "display_select",
+    "display_unit_select",
+    "light_select",
+    "quiet_select",
+    "ionizer_switch",
+    "beeper_switch",
+    "sleep_switch",
+    "xfan_switch",
+    "powersave_switch",
+    "turbo_switch",
+    "ifeel_switch",
+    "enable_tx_switch",
+    "dump_packets_switch",
+    "model_id_text_sensor",
+]
+
+# variant -> (climate options, logger level); the packet dump is only compiled in from DEBUG on
+VARIANTS = {
+    "full": ({}, "DEBUG"),
+    "no_dump": ({"exclude_entities": ["dump_packets_switch"]}, "INFO"),
+    "minimal": ({"exclude_entities": ALL_ENTITIES}, "INFO"),
+}
+
+# platform -> (platform block, UART pins, toolchain objdump)
+PLATFORMS = {
+    "esp8266": ({"esp8266": {"board": "esp01_1m"}}, {"tx_pin": 1, "rx_pin": 3}, "xtensa-lx106-elf-objdump"),
+    "esp32": ({"esp32": {"board": "esp32dev"}}, {"tx_pin": 17, "rx_pin": 16}, "xtensa-esp32-elf-objdump"),
+}
+
+COLUMNS = ["platform", "variant", "static_ram", "heap_idle", "sizeof_cnt", "flash", "component_dram",
+           "component_flash", "error"]
+
+SECTION_LINE = re.compile(r"^\s*\d+\s+(\S+)\s+([0-9a-f]+)\s")
+DUMP_LINE = re.compile(r"^\s*[0-9a-f]+\s+((?:[0-9a-f]{2,8}\s?)+)")
+FOOTPRINT_LOG = re.compile(r"\{\"footprint\":\"idle\".*?\}")
+
+
+def node_name(platform, variant):
+    return f"gree-fp-{variant.replace('_', '-')}-{platform}"
+
+
+def write_config(base, platform, variant, out_dir):
+    platform_block, pins, _ = PLATFORMS[platform]
+    climate_options, log_level = VARIANTS[variant]
+    name = node_name(platform, variant)
+
+    config = copy.deepcopy(base)
+    for key in PLATFORMS:
+        config.pop(key, None)
+    config["esphome"]["name"] = name
+    config.update(copy.deepcopy(platform_block))
+    config["logger"]["level"] = log_level
+    config["uart"].update(pins)
+    config["external_components"][0]["source"]["path"] = os.path.join(REPO, "components")
+    config["climate"][0].update(copy.deepcopy(climate_options))
+    config["climate"][0]["footprint_report"] = True
+
+    path = os.path.join(out_dir, f"{name}.yaml")
+    with open(path, "w") as f:
+        yaml.safe_dump(config, f, sort_keys=False)
+    return name, path
+
+
+def find_tool(name):
+    found = shutil.which(name)
+    if found:
+        return found
+    # PlatformIO keeps the toolchains out of PATH
+    packages = os.path.expanduser("~/.platformio/packages")
+    if os.path.isdir(packages):
+        for package in sorted(os.listdir(packages)):
+            candidate = os.path.join(packages, package, "bin", name)
+            if os.path.isfile(candidate):
+                return candidate
+    return None
+
+
+def section_ram(objdump, elf):
+    output = subprocess.run([objdump, "-h", elf], check=True, capture_output=True, text=True).stdout
+    total = 0
+    for line in output.splitlines():
+        parsed = SECTION_LINE.match(line)
+        if parsed and footprint.REGIONS.get(parsed.group(1)) == "dram":
+            total += int(parsed.group(2), 16)
+    return total
+
+
+def symbol_u32(objdump, elf, symbol):
+    """Value of a 4 byte constant in the ELF, None if it is not there."""
+    output = subprocess.run([objdump, "-t", elf], check=True, capture_output=True, text=True).stdout
+    for line in output.splitlines():
+        parsed = footprint.SYMBOL_LINE.match(line)
+        if parsed and parsed.group(4).strip() == symbol:
+            address, section = int(parsed.group(1), 16), parsed.group(2)
+            break
+    else:
+        return None
+
+    dump = subprocess.run([objdump, "-s", "-j", section, f"--start-address={address:#x}",
+                           f"--stop-address={address + 4:#x}", elf], check=True, capture_output=True, text=True).stdout
+    data = b""
+    for line in dump.splitlines():
+        parsed = DUMP_LINE.match(line)
+        if parsed and not line.startswith("Contents"):
+            data += bytes.fromhex(parsed.group(1).replace(" ", ""))
+    return int.from_bytes(data[:4], "little") if len(data) >= 4 else None
+
+
+def heap_from_log(logs, name):
+    if not logs:
+        return None
+    path = os.path.join(logs, f"{name}.log")
+    if not os.path.isfile(path):
+        return None
+    with open(path, "r", errors="replace") as f:
+        matches = FOOTPRINT_LOG.findall(f.read())
+    return json.loads(matches[-1])["heap_free"] if matches else None
+
+
+def measure(args, base, platform, variant):
+    row = {"platform": platform, "variant": variant}
+    name, path = write_config(base, platform, variant, args.out)
+
+    if not args.no_build:
+        result = subprocess.run(args.esphome.split() + ["compile", path], capture_output=True, text=True)
+        if result.returncode != 0:
+            row["error"] = "build failed, see " + path
+            sys.stderr.write(result.stdout[-4000:] + result.stderr[-4000:])
+            return row
+
+    build = os.path.join(args.out, ".esphome", "build", name, ".pioenvs", name)
+    elf = os.path.join(build, "firmware.elf")
+    if not os.path.isfile(elf):
+        row["error"] = "no firmware.elf in " + build
+        return row
+
+    objdump = find_tool(PLATFORMS[platform][2])
+    if objdump is None:
+        row["error"] = PLATFORMS[platform][2] + " not found"
+        return row
+
+    totals = footprint.totals(footprint.load_symbols(objdump, elf, "gree_ac"))
+    row["static_ram"] = section_ram(objdump, elf)
+    row["heap_idle"] = heap_from_log(args.logs, name)
+    row["sizeof_cnt"] = symbol_u32(objdump, elf, "gree_ac_sizeof_cnt")
+    row["flash"] = os.path.getsize(os.path.join(build, "firmware.bin"))
+    row["component_dram"] = totals["dram"]
+    row["component_flash"] = totals["flash"]
+    return row
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RAM/flash footprint of test_config.yaml across variants")
+    parser.add_argument("--config", default=os.path.join(REPO, "test_config.yaml"), help="base configuration")
+    parser.add_argument("--out", default=os.path.join(REPO, ".footprint"), help="directory for configs and builds")
+    parser.add_argument("--platform", action="append", choices=sorted(PLATFORMS), help="only this platform (repeatable)")
+    parser.add_argument("--variant", action="append", choices=list(VARIANTS), help="only this variant (repeatable)")
+    parser.add_argument("--esphome", default="esphome", help="command to run esphome (default: esphome)")
+    parser.add_argument("--no-build", action="store_true", help="only evaluate existing builds")
+    parser.add_argument("--logs", help="directory with <node name>.log device logs to take the idle heap from")
+    parser.add_argument("--format", choices=["csv", "json"], default="csv", help="output format (default: csv)")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        base = yaml.safe_load(f)
+    os.makedirs(args.out, exist_ok=True)
+
+    rows = []
+    for platform in args.platform or list(PLATFORMS):
+        for variant in args.variant or list(VARIANTS):
+            rows.append(measure(args, base, platform, variant))
+
+    if args.format == "json":
+        for row in rows:
+            print(json.dumps(row))
+    else:
+        writer = csv.DictWriter(sys.stdout, fieldnames=COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+if __name__ == "__main__":
+    main()
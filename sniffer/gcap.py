@@ -0,0 +1,348 @@
+#!/usr/bin/env python3
+"""Read, write, convert and replay GCAP captures (see documents/capture-format.txt)."""
+import argparse
+import random
+import re
+import select
+import struct
+import sys
+import time
+
+MAGIC = b"GCAP"
+VERSION = 1
+FILE_HEADER = struct.Struct("<4sBBH")
+RECORD_HEADER = struct.Struct("<IBB")
+
+DIR_FROM_UNIT = 0
+DIR_TO_UNIT = 1
+
+SYNC = 0x7E
+
+# [12:00:00.000] [RX] [7E.7E...] [50] - analyze_dongle.py, which plays the unit
+SNIFFER_LINE = re.compile(r"\[(\d\d):(\d\d):(\d\d)\.(\d{3})\] \[(RX|TX)\] \[([0-9A-F.]+)\]")
+# GCAP 39300100... / GCAP+ 0000... - component with packet_dump_format: capture
+GCAP_LINE = re.compile(r"\bGCAP(\+?) ([0-9A-Fa-f]+)\s*$")
+# " RX : 7E.7E... (50)" - component text dump, "RX: 7E.7E... (50)" - protocol.txt
+TEXT_LINE = re.compile(r"(?<![\w(])(RX|TX|\(TX\)) ?: ((?:[0-9A-F]{2}\.)*[0-9A-F]{2})(?: \((\d+)\))?")
+TEXT_CONTINUATION = re.compile(r"\s((?:[0-9A-F]{2}\.)*[0-9A-F]{2})\s*$")
+LOG_TIME = re.compile(r"^\[(\d\d):(\d\d):(\d\d)(?:\.(\d{3}))?\]")
+ANSI_ESCAPE = re.compile(r"\x1b\[[0-9;]*m")
+
+
+def format_hex_pretty(data):
+    return ".".join(f"{b:02X}" for b in data)
+
+
+def calculate_checksum(packet):
+    return sum(packet[2:-1]) & 0xFF
+
+
+def split_frames(buffer):
+    """Cuts all complete frames off the front of buffer, returns (frames, remaining buffer)."""
+    frames = []
+    while len(buffer) >= 4:
+        sync_idx = buffer.find(b"\x7E\x7E")
+        if sync_idx == -1:
+            buffer = buffer[-1:] if buffer[-1] == SYNC else bytearray()
+            break
+        buffer = buffer[sync_idx:]
+
+        len_idx = 2
+        while len_idx < len(buffer) and buffer[len_idx] == SYNC:
+            len_idx += 1
+        if len_idx >= len(buffer):
+            break
+
+        total = len_idx + 1 + buffer[len_idx]
+        if len(buffer) < total:
+            break
+        frames.append(bytes(buffer[:total]))
+        buffer = buffer[total:]
+    return frames, buffer
+
+
+def read_capture(path):
+    """Returns a list of (timestamp ms, direction, frame)."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if len(data) < FILE_HEADER.size:
+        raise ValueError(f"{path}: too short for a capture")
+    magic, version, _, _ = FILE_HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError(f"{path}: not a GCAP v{VERSION} file")
+
+    records = []
+    offset = FILE_HEADER.size
+    while offset + RECORD_HEADER.size <= len(data):
+        ts, direction, length = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        frame = data[offset:offset + length]
+        if len(frame) < length:
+            print(f"{path}: last record is truncated", file=sys.stderr)
+            break
+        records.append((ts, direction, frame))
+        offset += length
+    return records
+
+
+class CaptureWriter:
+    def __init__(self, path):
+        self.file = open(path, "wb")
+        self.file.write(FILE_HEADER.pack(MAGIC, VERSION, 0, 0))
+        self.start = time.monotonic()
+
+    def write(self, direction, frame, ts=None):
+        if ts is None:
+            ts = int((time.monotonic() - self.start) * 1000)
+        self.file.write(RECORD_HEADER.pack(ts & 0xFFFFFFFF, direction, len(frame)))
+        self.file.write(frame)
+        self.file.flush()
+
+    def close(self):
+        self.file.close()
+
+
+def time_of_day_ms(h, m, s, ms):
+    return ((int(h) * 60 + int(m)) * 60 + int(s)) * 1000 + int(ms or 0)
+
+
+def parse_log(lines, gap):
+    """Extracts (timestamp ms, direction, frame) from sniffer output, component logs or protocol.txt."""
+    records = []
+    gcap = None       # GCAP record still waiting for GCAP+ lines
+    text = None       # [ts, direction, frame, expected length] of a text frame spanning several lines
+    fake_time = 0
+
+    def line_time(line):
+        nonlocal fake_time
+        match = LOG_TIME.match(line)
+        if match:
+            return time_of_day_ms(*match.groups())
+        fake_time += gap
+        return fake_time
+
+    def finish_text():
+        nonlocal text
+        if text is not None:
+            records.append((text[0], text[1], bytes(text[2])))
+            text = None
+
+    for line in lines:
+        line = ANSI_ESCAPE.sub("", line).rstrip("\r\n")
+
+        match = SNIFFER_LINE.search(line)
+        if match:
+            finish_text()
+            h, m, s, ms, direction, hex_data = match.groups()
+            frame = bytes.fromhex(hex_data.replace(".", ""))
+            records.append((time_of_day_ms(h, m, s, ms), DIR_TO_UNIT if direction == "RX" else DIR_FROM_UNIT, frame))
+            continue
+
+        match = GCAP_LINE.search(line)
+        if match:
+            finish_text()
+            data = bytes.fromhex(match.group(2))
+            if match.group(1):
+                if gcap is None:
+                    continue  # continuation of a record we did not see the start of
+                gcap += data
+            else:
+                gcap = bytearray(data)
+            if len(gcap) >= RECORD_HEADER.size and len(gcap) >= RECORD_HEADER.size + gcap[5]:
+                ts, direction, length = RECORD_HEADER.unpack_from(gcap)
+                records.append((ts, direction, bytes(gcap[RECORD_HEADER.size:RECORD_HEADER.size + length])))
+                gcap = None
+            continue
+
+        match = TEXT_LINE.search(line)
+        if match:
+            finish_text()
+            direction, hex_data, length = match.groups()
+            if direction == "(TX)":
+                continue  # suppressed by the TX switch, never on the wire
+            frame = bytearray(bytes.fromhex(hex_data.replace(".", "")))
+            expected = int(length) if length else len(frame)
+            text = [line_time(line), DIR_FROM_UNIT if direction == "RX" else DIR_TO_UNIT, frame, expected]
+            if len(frame) >= expected:
+                finish_text()
+            continue
+
+        match = TEXT_CONTINUATION.search(line)
+        if text is not None and match:
+            text[2] += bytes.fromhex(match.group(1).replace(".", ""))
+            if len(text[2]) >= text[3]:
+                finish_text()
+
+    finish_text()
+    return records
+
+
+def cmd_convert(args):
+    with open(args.input, "r", errors="replace") as f:
+        records = parse_log(f, args.gap)
+
+    if not records:
+        print(f"{args.input}: no frames found", file=sys.stderr)
+        return 1
+
+    writer = CaptureWriter(args.output)
+    t0 = records[0][0]
+    bad = 0
+    for ts, direction, frame in records:
+        if len(frame) < 4 or frame[-1] != calculate_checksum(frame):
+            bad += 1
+        writer.write(direction, frame, ts - t0)
+    writer.close()
+
+    print(f"{args.output}: {len(records)} frames written, {bad} with a bad checksum")
+    return 0
+
+
+def cmd_show(args):
+    records = read_capture(args.capture)
+    previous = None
+    for ts, direction, frame in records:
+        delta = ts - previous if previous is not None else 0
+        previous = ts
+        cmd = f"{frame[3]:02X}" if len(frame) > 3 else "--"
+        arrow = "unit->module" if direction == DIR_FROM_UNIT else "module->unit"
+        print(f"{ts:10d} +{delta:6d} {arrow} cmd {cmd} [{format_hex_pretty(frame)}] ({len(frame)})")
+    print(f"{len(records)} frames")
+    return 0
+
+
+class NoiseInjector:
+    """Corrupts replayed frames to exercise the resync logic of the component."""
+
+    def __init__(self, args):
+        self.rng = random.Random(args.seed)
+        self.bit_errors = args.bit_errors
+        self.drop = args.drop
+        self.truncate = args.truncate
+        self.garbage = args.garbage
+        self.corrupted = 0
+
+    def enabled(self):
+        return any((self.bit_errors, self.drop, self.truncate, self.garbage))
+
+    def apply(self, frame):
+        rng = self.rng
+        out = bytearray()
+        if rng.random() < self.garbage:
+            # garbage bursts favour the sync byte, the nastiest case for the synchronizer
+            out += bytes(rng.choice((SYNC, rng.randrange(256))) for _ in range(rng.randint(1, 32)))
+        for b in frame:
+            if rng.random() < self.drop:
+                continue
+            if rng.random() < self.bit_errors:
+                b ^= 1 << rng.randrange(8)
+            out.append(b)
+        if rng.random() < self.truncate and len(out) > 1:
+            out = out[:rng.randrange(1, len(out))]
+        if bytes(out) != frame:
+            self.corrupted += 1
+        return bytes(out)
+
+
+def cmd_replay(args):
+    import serial
+
+    records = [r for r in read_capture(args.capture) if r[1] == DIR_FROM_UNIT]
+    if not records:
+        print(f"{args.capture}: no frames from the unit to replay", file=sys.stderr)
+        return 1
+
+    ser = serial.Serial(
+        port=args.port,
+        baudrate=4800,
+        parity=serial.PARITY_EVEN,
+        stopbits=serial.STOPBITS_ONE,
+        bytesize=serial.EIGHTBITS,
+        timeout=0,
+    )
+    ser.reset_input_buffer()
+    writer = CaptureWriter(args.record) if args.record else None
+    noise = NoiseInjector(args)
+    buffer = bytearray()
+
+    def poll(until):
+        # print (and record) what the component answers while we wait for the next frame
+        nonlocal buffer
+        while True:
+            remaining = until - time.monotonic()
+            if remaining <= 0:
+                break
+            rlist, _, _ = select.select([ser], [], [], min(remaining, 0.05))
+            if rlist:
+                buffer.extend(ser.read(ser.in_waiting or 1))
+                frames, buffer = split_frames(buffer)
+                for frame in frames:
+                    print(f"  <- [{format_hex_pretty(frame)}] ({len(frame)})")
+                    if writer:
+                        writer.write(DIR_TO_UNIT, frame)
+
+    start = time.monotonic()
+    t0 = records[0][0]
+    try:
+        for ts, _, frame in records:
+            if not args.fast:
+                poll(start + (ts - t0) / 1000.0)
+            if noise.enabled():
+                frame = noise.apply(frame)
+            ser.write(frame)
+            print(f"-> [{format_hex_pretty(frame)}] ({len(frame)})")
+            if writer:
+                writer.write(DIR_FROM_UNIT, frame)
+        ser.flush()
+        poll(time.monotonic() + args.tail)
+    except KeyboardInterrupt:
+        print("Stopping...")
+    finally:
+        ser.close()
+        if writer:
+            writer.close()
+
+    elapsed = time.monotonic() - start
+    print(f"{len(records)} frames replayed in {elapsed:.1f} s")
+    if noise.enabled():
+        print(f"{noise.corrupted} frames corrupted, use gree_ac.dump_sync_stats on the device for the recovery times")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gree AC capture tool")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("convert", help="convert sniffer output or component logs to a .gcap file")
+    p.add_argument("input", help="text file with sniffer output, ESPHome logs or protocol.txt style samples")
+    p.add_argument("output", help=".gcap file to write")
+    p.add_argument("--gap", type=int, default=300,
+                   help="ms between frames for lines without a timestamp (default: 300)")
+    p.set_defaults(func=cmd_convert)
+
+    p = sub.add_parser("show", help="print the frames of a .gcap file")
+    p.add_argument("capture")
+    p.set_defaults(func=cmd_show)
+
+    p = sub.add_parser("replay", help="play the unit side of a capture into a device running the component")
+    p.add_argument("capture")
+    p.add_argument("--port", default="/dev/ttyUSB0", help="Serial port to use (default: /dev/ttyUSB0)")
+    p.add_argument("--fast", action="store_true", help="send frames back to back instead of at the captured pace")
+    p.add_argument("--record", help="write the replayed frames and the answers of the component to this .gcap file")
+    p.add_argument("--tail", type=float, default=2.0,
+                   help="seconds to keep listening after the last frame (default: 2)")
+    p.add_argument("--bit-errors", type=float, default=0.0, help="probability per byte of a flipped bit")
+    p.add_argument("--drop", type=float, default=0.0, help="probability per byte of dropping it")
+    p.add_argument("--truncate", type=float, default=0.0, help="probability per frame of cutting it short")
+    p.add_argument("--garbage", type=float, default=0.0,
+                   help="probability per frame of a burst of 1-32 random bytes in front of it")
+    p.add_argument("--seed", type=int, default=None, help="random seed, to repeat a noisy run exactly")
+    p.set_defaults(func=cmd_replay)
+
+    args = parser.parse_args()
+    sys.exit(args.func(args))
+
+
+if __name__ == "__main__":
+    main()
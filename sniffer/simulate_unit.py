@@ -0,0 +1,265 @@
+#!/usr/bin/env python3
+"""Simulates a Gree AC unit on a pseudo-terminal (or a real serial port) for end to end tests of the component."""
+import argparse
+import os
+import select
+import time
+import tty
+
+import gcap
+
+SYNC = 0x7E
+
+CMD_OUT_PARAMS_SET = 0x01
+CMD_OUT_SYNC_TIME = 0x03
+CMD_OUT_MAC_REPORT = 0x04
+CMD_IN_UNIT_REPORT = 0x31
+CMD_IN_TIME_REPLY = 0x35
+CMD_IN_MODEL_ID = 0x44
+
+PAYLOAD_LEN = 45
+SET_AF_BYTE = 3
+SET_AF_VAL = 0xAF
+REPORT_PWR_BYTE = 4
+REPORT_PWR_MASK = 0x80
+REPORT_TEMP_SET_BYTE = 5
+REPORT_TEMP_ACT_BYTE = 42
+REPORT_TEMP_ACT_OFF = 40
+
+# (byte, mask) of everything a set frame with 0xAF changes, same layout as the report
+SETTABLE_FIELDS = [
+    (0, 0b00000100),   # ionizer 2
+    (4, 0b11111111),   # power, mode, sleep, fan speed 2
+    (5, 0b11110000),   # target temperature
+    (6, 0b00001111),   # x-fan, ionizer 1, display on, turbo
+    (7, 0b10000000),   # display unit
+    (8, 0b11110111),   # vertical / horizontal swing
+    (9, 0b01110000),   # i-feel, display mode
+    (11, 0b01000000),  # powersave
+    (16, 0b00001100),  # quiet, quiet auto
+    (18, 0b00000111),  # fan speed 1
+    (40, 0b00000001),  # beeper off
+]
+
+# heating, 24 degrees, fan auto - first sample in documents/protocol.txt
+INITIAL_REPORT = bytes([
+    0x04, 0x00, 0x40, 0x00, 0xC0, 0x80, 0x0C, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x00,
+])
+
+# answers analyze_dongle.py gives to the module, without sync, length and checksum
+MODEL_ID_PAYLOAD = bytes([0x01, 0x00, 0x01] + [0x00] * 20 + [0x01])
+TIME_REPLY_PAYLOAD = bytes([0x04, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x39,
+                            0x39, 0x3E] + [0x00] * 29)
+
+
+def build_frame(cmd, payload):
+    frame = bytearray([SYNC, SYNC, len(payload) + 2, cmd]) + payload + b"\x00"
+    frame[-1] = gcap.calculate_checksum(frame)
+    return bytes(frame)
+
+
+class PtyLink:
+    def __init__(self):
+        self.master, self.slave = os.openpty()
+        tty.setraw(self.slave)
+        self.name = os.ttyname(self.slave)
+
+    def fileno(self):
+        return self.master
+
+    def read(self):
+        return os.read(self.master, 256)
+
+    def write(self, data):
+        os.write(self.master, data)
+
+    def close(self):
+        os.close(self.master)
+        os.close(self.slave)
+
+
+class SerialLink:
+    def __init__(self, port):
+        import serial
+        self.ser = serial.Serial(port=port, baudrate=4800, parity=serial.PARITY_EVEN,
+                                 stopbits=serial.STOPBITS_ONE, bytesize=serial.EIGHTBITS, timeout=0)
+        self.name = port
+
+    def fileno(self):
+        return self.ser.fileno()
+
+    def read(self):
+        return self.ser.read(self.ser.in_waiting or 1)
+
+    def write(self, data):
+        self.ser.write(data)
+
+    def close(self):
+        self.ser.close()
+
+
+class Unit:
+    def __init__(self, args):
+        self.args = args
+        self.report = bytearray(INITIAL_REPORT)
+        self.report[REPORT_TEMP_ACT_BYTE] = args.ambient + REPORT_TEMP_ACT_OFF
+        self.last_drift = time.monotonic()
+        self.stats = {"rx": 0, "bad": 0, "applied": 0, "reports": 0}
+        self.cmd_counts = {}
+
+    def power(self):
+        return (self.report[REPORT_PWR_BYTE] & REPORT_PWR_MASK) != 0
+
+    def target(self):
+        return (self.report[REPORT_TEMP_SET_BYTE] >> 4) + 16
+
+    def current(self):
+        return self.report[REPORT_TEMP_ACT_BYTE] - REPORT_TEMP_ACT_OFF
+
+    def drift(self, now):
+        # the room follows the target by one degree per drift period while running, back to ambient when off
+        if now - self.last_drift < self.args.drift_period:
+            return
+        self.last_drift = now
+        goal = self.target() if self.power() else self.args.ambient
+        step = (goal > self.current()) - (goal < self.current())
+        self.report[REPORT_TEMP_ACT_BYTE] += step
+
+    def apply_set(self, payload):
+        if len(payload) < PAYLOAD_LEN or payload[SET_AF_BYTE] != SET_AF_VAL:
+            return []
+        changed = []
+        for byte, mask in SETTABLE_FIELDS:
+            value = (self.report[byte] & ~mask) | (payload[byte] & mask)
+            if value != self.report[byte]:
+                changed.append(byte)
+                self.report[byte] = value
+        self.stats["applied"] += 1
+        return changed
+
+    def handle(self, frame):
+        """Returns the frames to answer with."""
+        self.stats["rx"] += 1
+        if len(frame) < 5 or frame[-1] != gcap.calculate_checksum(frame):
+            self.stats["bad"] += 1
+            return []
+
+        cmd = frame[3]
+        self.cmd_counts[cmd] = self.cmd_counts.get(cmd, 0) + 1
+        payload = frame[4:-1]
+
+        if cmd == CMD_OUT_PARAMS_SET:
+            changed = self.apply_set(payload)
+            if changed:
+                log(f"applied set frame, bytes {changed} changed: power={int(self.power())} target={self.target()}")
+            return [self.report_frame()]
+        if cmd == CMD_OUT_MAC_REPORT:
+            return [build_frame(CMD_IN_MODEL_ID, MODEL_ID_PAYLOAD)]
+        if cmd == CMD_OUT_SYNC_TIME:
+            return [build_frame(CMD_IN_TIME_REPLY, TIME_REPLY_PAYLOAD)]
+        return []
+
+    def report_frame(self):
+        self.stats["reports"] += 1
+        return build_frame(CMD_IN_UNIT_REPORT, bytes(self.report))
+
+
+def log(message):
+    print(time.strftime("%H:%M:%S") + f".{int(time.time() * 1000) % 1000:03d} {message}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gree AC unit simulator")
+    parser.add_argument("--port", help="use this serial port instead of creating a pty")
+    parser.add_argument("--report-interval", type=float, default=1.0,
+                        help="seconds without traffic after which an unsolicited report is sent (default: 1)")
+    parser.add_argument("--latency", type=float, default=0.05, help="seconds before answering a frame (default: 0.05)")
+    parser.add_argument("--jitter", type=float, default=0.0, help="random extra latency up to this many seconds")
+    parser.add_argument("--no-wire-delay", action="store_true",
+                        help="do not pace the output at 4800 baud (a pty is otherwise unlimited)")
+    parser.add_argument("--ambient", type=int, default=26, help="room temperature in degrees (default: 26)")
+    parser.add_argument("--drift-period", type=float, default=30.0,
+                        help="seconds per degree the room moves towards the target (default: 30)")
+    parser.add_argument("--bit-errors", type=float, default=0.0, help="probability per byte of a flipped bit")
+    parser.add_argument("--drop", type=float, default=0.0, help="probability per byte of dropping it")
+    parser.add_argument("--truncate", type=float, default=0.0, help="probability per frame of cutting it short")
+    parser.add_argument("--garbage", type=float, default=0.0,
+                        help="probability per frame of a burst of random bytes in front of it")
+    parser.add_argument("--seed", type=int, default=None, help="random seed for jitter and errors")
+    parser.add_argument("--capture", help="write all frames to this .gcap file")
+    parser.add_argument("-v", "--verbose", action="store_true", help="print every frame")
+    args = parser.parse_args()
+
+    link = SerialLink(args.port) if args.port else PtyLink()
+    unit = Unit(args)
+    noise = gcap.NoiseInjector(args)
+    capture = gcap.CaptureWriter(args.capture) if args.capture else None
+    pending = []  # (due time, frame)
+    buffer = bytearray()
+    last_traffic = time.monotonic()
+
+    log(f"Simulated unit on {link.name}, Ctrl+C to stop")
+
+    def send(frame):
+        if noise.enabled():
+            frame = noise.apply(frame)
+        link.write(frame)
+        if not args.no_wire_delay:
+            time.sleep(len(frame) * 11 / 4800)  # 8E1 = 11 bits per byte
+        if capture:
+            capture.write(gcap.DIR_FROM_UNIT, frame)
+        if args.verbose:
+            log(f"TX [{gcap.format_hex_pretty(frame)}] ({len(frame)})")
+
+    try:
+        while True:
+            now = time.monotonic()
+            timeout = 0.05
+            if pending:
+                timeout = max(0.0, min(timeout, pending[0][0] - now))
+            rlist, _, _ = select.select([link], [], [], timeout)
+
+            if rlist:
+                try:
+                    chunk = link.read()
+                except OSError:
+                    chunk = b""  # pty without a reader on the other side yet
+                buffer.extend(chunk)
+                frames, buffer = gcap.split_frames(buffer)
+                for frame in frames:
+                    last_traffic = time.monotonic()
+                    if capture:
+                        capture.write(gcap.DIR_TO_UNIT, frame)
+                    if args.verbose:
+                        log(f"RX [{gcap.format_hex_pretty(frame)}] ({len(frame)})")
+                    delay = args.latency + noise.rng.uniform(0, args.jitter)
+                    for answer in unit.handle(frame):
+                        pending.append((last_traffic + delay, answer))
+                    pending.sort(key=lambda p: p[0])
+
+            now = time.monotonic()
+            while pending and pending[0][0] <= now:
+                send(pending.pop(0)[1])
+
+            if now - last_traffic >= args.report_interval:
+                last_traffic = now
+                send(unit.report_frame())
+
+            unit.drift(now)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        link.close()
+        if capture:
+            capture.close()
+
+    counts = ", ".join(f"{cmd:02X}: {n}" for cmd, n in sorted(unit.cmd_counts.items()))
+    log(f"{unit.stats['rx']} frames received ({counts}), {unit.stats['bad']} bad checksums, "
+        f"{unit.stats['applied']} set frames with 0xAF, {unit.stats['reports']} reports sent, "
+        f"{noise.corrupted} frames corrupted")
+
+
+if __name__ == "__main__":
+    main()
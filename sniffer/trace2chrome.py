@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Converts the output of gree_ac.dump_trace into Chrome trace JSON (chrome://tracing, ui.perfetto.dev)."""
+import argparse
+import json
+import re
+import sys
+
+TRACE_LINE = re.compile(r"\bTRACE (\d+) (\w+) (\d+)")
+ANSI_ESCAPE = re.compile(r"\x1b\[[0-9;]*m")
+
+# one timeline row per path
+LANES = {
+    "rx_first_byte": ("RX", 1),
+    "rx_frame": ("RX", 1),
+    "verify": ("RX", 1),
+    "decode": ("RX", 1),
+    "publish": ("Publish", 2),
+    "control": ("Control / TX", 3),
+    "af_build": ("Control / TX", 3),
+    "tx": ("Control / TX", 3),
+}
+
+# (span name, start point, end point, lane): a span ends at the first end point after its start point
+SPANS = [
+    ("receive", "rx_first_byte", "rx_frame", 1),
+    ("verify", "rx_frame", "verify", 1),
+    ("decode", "verify", "decode", 1),
+    ("control -> AF frame", "control", "af_build", 3),
+    ("AF frame -> TX", "af_build", "tx", 3),
+]
+
+
+def parse(lines):
+    """Returns (time us, point, arg) sorted by time, with the 32 bit micros() wraparound removed.
+
+    Points are not always recorded in time order (with rx_task the RX points are recorded when the main loop
+    takes the frame), so only a jump back by more than half the range counts as a wraparound.
+    """
+    events = []
+    offset = 0
+    previous = None
+    for line in lines:
+        match = TRACE_LINE.search(ANSI_ESCAPE.sub("", line))
+        if not match:
+            continue
+        raw = int(match.group(1))
+        if previous is not None and previous - raw > 1 << 31:
+            offset += 1 << 32
+        elif previous is not None and raw - previous > 1 << 31:
+            offset -= 1 << 32  # an early point recorded after the wraparound
+        previous = raw
+        events.append((raw + offset, match.group(2), int(match.group(3))))
+    events.sort(key=lambda event: event[0])
+    return events
+
+
+def to_chrome(events):
+    trace = []
+    for name, tid in {lane: tid for lane, tid in LANES.values()}.items():
+        trace.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}})
+
+    for ts, point, arg in events:
+        _, tid = LANES.get(point, ("Other", 4))
+        trace.append({"name": point, "ph": "i", "s": "t", "ts": ts, "pid": 1, "tid": tid, "args": {"arg": arg}})
+
+    for name, start, end, tid in SPANS:
+        opened = None
+        for ts, point, _ in events:
+            if point == start and opened is None:
+                opened = ts
+            elif point == end and opened is not None:
+                trace.append({"name": name, "ph": "X", "ts": opened, "dur": ts - opened, "pid": 1, "tid": tid})
+                opened = None
+
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a gree_ac trace dump to Chrome trace JSON")
+    parser.add_argument("input", nargs="?", help="log file with TRACE lines (default: stdin)")
+    parser.add_argument("-o", "--output", help="JSON file to write (default: stdout)")
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, "r", errors="replace") as f:
+            events = parse(f)
+    else:
+        events = parse(sys.stdin)
+
+    if not events:
+        print("no TRACE lines found", file=sys.stderr)
+        sys.exit(1)
+
+    result = json.dumps(to_chrome(events))
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(result)
+    else:
+        print(result)
+
+
+if __name__ == "__main__":
+    main()